@@ -1,11 +1,46 @@
 #version 330 core
 
 in vec2 TexCoords;
+flat in int Material;
+
+const int MAX_MATERIALS = 64; // MAX_MATERIALS in material_array.hpp
+
+// Where each material sits in the material array, see MaterialArray
+struct MaterialRegion
+{
+    vec4 rect;  // xy offset, zw scale into the layer
+    vec4 layer; // x the layer, y the array's last mip level
+};
+layout (std140) uniform Materials
+{
+    MaterialRegion regions[MAX_MATERIALS];
+};
 
 uniform sampler2D tex;
+uniform sampler2DArray materials;
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = texture(tex, TexCoords);
+    // Derivatives are only defined outside the branch below
+    vec2 uvDx = dFdx(TexCoords), uvDy = dFdy(TexCoords);
+
+    if (Material < 0)
+    {
+        FragColor = texture(tex, TexCoords);
+        return;
+    }
+
+    // Pick the level like the hardware would, so the clamp below can be sized for it
+    MaterialRegion region = regions[Material];
+    vec2 size = vec2(textureSize(materials, 0).xy);
+    vec2 texelDx = uvDx * region.rect.zw * size, texelDy = uvDy * region.rect.zw * size;
+    float lod = clamp(0.5 * log2(max(dot(texelDx, texelDx), dot(texelDy, texelDy))), 0.0, region.layer.y);
+
+    // Stay half a texel of the coarser blended level inside the region so filtering never reads
+    // an atlas neighbour. Regions are aligned so their edges are texel edges down to the last level
+    vec2 halfTexel = min(0.5 * exp2(ceil(lod)) / size, 0.5 * region.rect.zw);
+    vec2 uv = region.rect.xy + clamp(TexCoords, 0.0, 1.0) * region.rect.zw;
+    uv = clamp(uv, region.rect.xy + halfTexel, region.rect.xy + region.rect.zw - halfTexel);
+    FragColor = textureLod(materials, vec3(uv, region.layer.x), lod);
 }
\ No newline at end of file
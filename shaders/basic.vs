@@ -1,15 +1,24 @@
 #version 330 core
 layout (location=0) in vec3 aPos;
 layout (location=1) in vec2 aTexCoords;
+// Material index + 1, batches fill it in. Draws without it read the default 0
+layout (location=2) in float aMaterial;
 
 out vec2 TexCoords;
+flat out int Material;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Shared by every program, updated once per frame
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1);
     TexCoords = aTexCoords;
+    Material = int(aMaterial + 0.5) - 1;
 }
\ No newline at end of file
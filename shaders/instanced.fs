@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 TexCoords;
+flat in float Layer;
+
+uniform sampler2D tex;
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = texture(tex, TexCoords);
+}
\ No newline at end of file
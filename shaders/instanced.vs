@@ -0,0 +1,23 @@
+#version 330 core
+layout (location=0) in vec3 aPos;
+layout (location=1) in vec2 aTexCoords;
+// Per-instance, advanced once per instance (see InstancedMesh)
+layout (location=2) in mat4 aModel;
+layout (location=6) in float aLayer;
+
+out vec2 TexCoords;
+flat out float Layer;
+
+// Shared by every program, updated once per frame
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1);
+    TexCoords = aTexCoords;
+    Layer = aLayer;
+}
\ No newline at end of file
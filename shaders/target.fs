@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec3 Normal;
+
+out vec4 FragColor;
+
+// Flat color with a fixed overhead light, targets must stand out from the walls
+const vec3 TARGET_COLOR = vec3(0.9, 0.15, 0.1);
+const vec3 LIGHT_DIR = normalize(vec3(0.3, 1.0, 0.5));
+
+void main()
+{
+    float diffuse = max(dot(normalize(Normal), LIGHT_DIR), 0.0);
+    FragColor = vec4(TARGET_COLOR * (0.35 + 0.65 * diffuse), 1.0);
+}
\ No newline at end of file
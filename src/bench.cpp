@@ -0,0 +1,214 @@
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "window_mgr.hpp"
+#include "resource_mgr.hpp"
+#include "scene.hpp"
+#include "camera_uniforms.hpp"
+#include "render_queue.hpp"
+#include "camera.hpp"
+#include "texture_loader.hpp"
+#include "stream_buffer.hpp"
+
+/**
+ * Headless benchmark: renders the scene into an offscreen framebuffer of a
+ * hidden window while replaying a scripted camera path, then reports CPU
+ * and GPU frame time statistics as JSON.
+ *
+ * Usage: aim-bench [--frames N] [--warmup N] [--out file.json]
+ */
+
+#define BENCH_WIDTH  1366
+#define BENCH_HEIGHT 768
+#define BENCH_TITLE  "AIM-BENCH"
+#define BENCH_LEVEL  "levels/arena.txt"
+
+// Frames in flight for the GPU timer queries, results are read this many frames late so they never stall
+#define QUERY_RING 4
+// Frames for one loop of the scripted camera path
+#define PATH_FRAMES 600
+
+struct TimingStats
+{
+    double mean, p50, p99, max;
+};
+
+TimingStats computeStats(std::vector<double> samples)
+{
+    TimingStats stats = { 0.0, 0.0, 0.0, 0.0 };
+    if(samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for(double sample: samples) sum += sample;
+
+    auto percentile = [&](double p) { return samples[(size_t)std::floor(p * (samples.size() - 1))]; };
+    stats.mean = sum / samples.size();
+    stats.p50 = percentile(0.50);
+    stats.p99 = percentile(0.99);
+    stats.max = samples.back();
+    return stats;
+}
+
+void writeStats(std::ostream& out, const char* name, const TimingStats& stats, bool last)
+{
+    out << "  \"" << name << "\": { "
+        << "\"mean\": " << stats.mean << ", "
+        << "\"p50\": " << stats.p50 << ", "
+        << "\"p99\": " << stats.p99 << ", "
+        << "\"max\": " << stats.max << " }" << (last ? "" : ",") << "\n";
+}
+
+// Walks a loop around the room while sweeping yaw and pitch, fully determined by the frame index
+void scriptedCamera(Camera& camera, unsigned int frame)
+{
+    float t = (float)(frame % PATH_FRAMES) / PATH_FRAMES;
+    float angle = 2.0f * 3.14159265f * t;
+
+    camera.Position = glm::vec3(0.6f * std::sin(angle), 0.35f, 1.5f * std::cos(angle));
+    camera.SetOrientation(-90.0f + 120.0f * std::sin(angle), 20.0f * std::sin(2.0f * angle));
+}
+
+int32_t main(int argc, char** argv)
+{
+    unsigned int frames = 1000, warmup = 60;
+    const char* outFile = nullptr;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--warmup") && i + 1 < argc) warmup = std::atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--out") && i + 1 < argc) outFile = argv[++i];
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--frames N] [--warmup N] [--out file.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    GLFWwindow* window;
+    try{
+        window = initWindow(BENCH_WIDTH, BENCH_HEIGHT, BENCH_TITLE, false);
+    }
+    catch ( std::exception& e )
+    {
+        std::cout << "EXCEPTION occured while trying to init screen: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Offscreen target, independent of whether the hidden window has a usable default framebuffer
+    unsigned int FBO, colorRBO, depthRBO;
+    glGenFramebuffers(1, &FBO);
+    glGenRenderbuffers(1, &colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, BENCH_WIDTH, BENCH_HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::BENCH: Offscreen framebuffer is incomplete" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 1;
+    }
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+
+    Camera camera(true, glm::vec3(0.0f, 0.35f, 1.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    CameraUniforms::Init();
+    Scene scene;
+    scene.load(BENCH_LEVEL);
+    // Measure the real textures, not the placeholders
+    TextureLoader::Finish();
+    RenderQueue renderQueue;
+
+    unsigned int queries[QUERY_RING];
+    glGenQueries(QUERY_RING, queries);
+
+    std::vector<double> cpuTimes, gpuTimes;
+    cpuTimes.reserve(frames);
+    gpuTimes.reserve(frames);
+
+    // Results of the query issued in the given frame, blocks only if the GPU is QUERY_RING frames behind
+    auto collectGpuTime = [&](unsigned int frame)
+    {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[frame % QUERY_RING], GL_QUERY_RESULT, &elapsed);
+        if(frame >= warmup) gpuTimes.push_back(elapsed / 1.0e6);
+    };
+
+    glEnable(GL_DEPTH_TEST);
+    const unsigned int totalFrames = warmup + frames;
+    for(unsigned int frame = 0; frame < totalFrames; frame++)
+    {
+        auto cpuStart = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[frame % QUERY_RING]);
+
+        scriptedCamera(camera, frame);
+        StreamBuffer::BeginFrame();
+
+        glClearColor(0.5f, 0.6f, 0.6f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 view = camera.GetViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)BENCH_WIDTH / BENCH_HEIGHT, 0.1f, 100.0f);
+        CameraUniforms::Update(projection, view);
+
+        scene.submit(renderQueue, Frustum(projection * view));
+        renderQueue.flush();
+        StreamBuffer::EndFrame();
+
+        glEndQuery(GL_TIME_ELAPSED);
+        glFlush();
+        auto cpuEnd = std::chrono::steady_clock::now();
+
+        if(frame >= warmup) cpuTimes.push_back(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+
+        // The next frame reuses the oldest query, read it now
+        if(frame + 1 >= QUERY_RING) collectGpuTime(frame + 1 - QUERY_RING);
+    }
+    // Drain the queries still in flight
+    for(unsigned int frame = (totalFrames >= QUERY_RING - 1 ? totalFrames - (QUERY_RING - 1) : 0); frame < totalFrames; frame++)
+        collectGpuTime(frame);
+
+    std::ofstream file;
+    if(outFile) file.open(outFile);
+    std::ostream& out = outFile ? file : std::cout;
+
+    out << "{\n";
+    out << "  \"renderer\": \"" << (const char*)glGetString(GL_RENDERER) << "\",\n";
+    out << "  \"width\": " << BENCH_WIDTH << ",\n";
+    out << "  \"height\": " << BENCH_HEIGHT << ",\n";
+    out << "  \"frames\": " << frames << ",\n";
+    writeStats(out, "cpu_ms", computeStats(cpuTimes), false);
+    writeStats(out, "gpu_ms", computeStats(gpuTimes), true);
+    out << "}" << std::endl;
+
+    // Clean up
+    glDeleteQueries(QUERY_RING, queries);
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteRenderbuffers(1, &colorRBO);
+    glDeleteRenderbuffers(1, &depthRBO);
+    scene.clear();
+    StreamBuffer::Clear();
+    CameraUniforms::Clear();
+    ResourceManager::Clear();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+
+void BVH::build(const std::vector<AABB>& bounds)
+{
+    this->clear();
+    if(bounds.empty()) return;
+
+    std::vector<glm::vec3> centers(bounds.size());
+    this->items.resize(bounds.size());
+    for(uint32_t i = 0; i < bounds.size(); i++)
+    {
+        this->items[i] = i;
+        centers[i] = bounds[i].center();
+    }
+
+    // A binary tree over n leaves has at most 2n - 1 nodes
+    this->nodes.reserve(bounds.size() * 2);
+    Node root;
+    root.left = 0;
+    root.first = 0;
+    root.count = bounds.size();
+    this->nodes.push_back(root);
+    this->split(0, bounds, centers);
+
+    // Item boxes in tree order, read by the leaf tests
+    this->itemBounds.resize(this->items.size());
+    for(uint32_t i = 0; i < this->items.size(); i++) this->itemBounds[i] = bounds[this->items[i]];
+}
+
+void BVH::split(uint32_t nodeIndex, const std::vector<AABB>& bounds, std::vector<glm::vec3>& centers)
+{
+    uint32_t first = this->nodes[nodeIndex].first;
+    uint32_t count = this->nodes[nodeIndex].count;
+
+    AABB nodeBounds, centerBounds;
+    for(uint32_t i = first; i < first + count; i++)
+    {
+        nodeBounds.extend(bounds[this->items[i]]);
+        centerBounds.extend(centers[this->items[i]]);
+    }
+    this->nodes[nodeIndex].bounds = nodeBounds;
+
+    if(count <= BVH_LEAF_SIZE) return;
+
+    // Median split along the axis where the centers are spread the most
+    glm::vec3 spread = centerBounds.max - centerBounds.min;
+    int axis = 0;
+    if(spread.y > spread[axis]) axis = 1;
+    if(spread.z > spread[axis]) axis = 2;
+
+    uint32_t half = count / 2;
+    std::nth_element(this->items.begin() + first, this->items.begin() + first + half, this->items.begin() + first + count,
+        [&centers, axis](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+
+    // Children are pushed as a pair, nodes may reallocate so index instead of holding references
+    uint32_t left = this->nodes.size();
+    Node child;
+    child.left = 0;
+    child.first = first;
+    child.count = half;
+    this->nodes.push_back(child);
+    child.first = first + half;
+    child.count = count - half;
+    this->nodes.push_back(child);
+    this->nodes[nodeIndex].left = left;
+
+    this->split(left, bounds, centers);
+    this->split(left + 1, bounds, centers);
+}
+
+void BVH::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    if(this->nodes.empty()) return;
+
+    // Depth is logarithmic in the item count, 64 entries is far more than any level needs
+    uint32_t stack[64];
+    unsigned int top = 0;
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        const Node& node = this->nodes[stack[--top]];
+
+        FrustumTest test = frustum.classify(node.bounds);
+        if(test == FRUSTUM_OUTSIDE) continue;
+
+        // Fully visible subtrees accept their whole item range untested
+        if(test == FRUSTUM_INSIDE)
+        {
+            visible.insert(visible.end(), this->items.begin() + node.first, this->items.begin() + node.first + node.count);
+            continue;
+        }
+
+        // A straddling leaf tests its items, their union may be much larger than any one of them
+        if(node.left == 0)
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i++)
+                if(node.count == 1 || frustum.intersects(this->itemBounds[i])) visible.push_back(this->items[i]);
+            continue;
+        }
+
+        stack[top++] = node.left;
+        stack[top++] = node.left + 1;
+    }
+}
+
+void BVH::clear()
+{
+    this->nodes.clear();
+    this->items.clear();
+    this->itemBounds.clear();
+}
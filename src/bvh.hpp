@@ -0,0 +1,99 @@
+#ifndef __BVH_HPP__
+#define __BVH_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+#include "raycast.hpp"
+
+// Most items kept in a single leaf
+const uint32_t BVH_LEAF_SIZE = 4;
+
+// Bounding volume hierarchy over static object bounds, built once at
+// level load. Items are identified by their index in the bounds array
+// given to build(). Every subtree covers a contiguous run of the
+// reordered item list, so a subtree fully inside the frustum is
+// accepted without testing its children.
+class BVH
+{
+    public:
+        struct Node
+        {
+            AABB bounds;
+            uint32_t left;  // Index of the first child, the second follows it. 0 for leaves
+            uint32_t first; // First entry in the item list covered by this subtree
+            uint32_t count; // Number of items covered by this subtree
+        };
+
+    private:
+        std::vector<Node> nodes;
+        std::vector<uint32_t> items; // Item ids, reordered so each subtree is contiguous
+        std::vector<AABB> itemBounds; // Parallel to items
+
+        void split(uint32_t nodeIndex, const std::vector<AABB>& bounds, std::vector<glm::vec3>& centers);
+
+    public:
+        // Rebuilds the hierarchy over the given boxes
+        void build(const std::vector<AABB>& bounds);
+        // Appends the ids of every item whose box may be visible, in no particular order
+        void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+        // Visits the leaves the ray enters, nearest first, as leafTest(const uint32_t* ids, uint32_t count, RayHit& hit).
+        // The test lowers hit.distance when it finds something closer, which skips every node entered beyond it
+        template<typename LeafTest>
+        void raycast(const Ray& ray, RayHit& hit, LeafTest leafTest) const;
+        void clear();
+
+        bool empty() const { return nodes.empty(); }
+        // Box around every item
+        AABB bounds() const { return nodes.empty() ? AABB() : nodes[0].bounds; }
+        size_t nodeCount() const { return nodes.size(); }
+        const std::vector<Node>& getNodes() const { return nodes; }
+        const std::vector<uint32_t>& getItems() const { return items; }
+};
+
+template<typename LeafTest>
+void BVH::raycast(const Ray& ray, RayHit& hit, LeafTest leafTest) const
+{
+    if(this->nodes.empty()) return;
+
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+    float entry[4];
+    if(!Raycast::IntersectBoxes(ray, inverseDirection, &this->nodes[0].bounds, 1, ray.maxDistance, entry)) return;
+
+    uint32_t stack[64];
+    float stackEntry[64];
+    unsigned int top = 0;
+    stack[top] = 0;
+    stackEntry[top++] = entry[0];
+
+    while(top > 0)
+    {
+        top--;
+        float limit = std::min(hit.distance, ray.maxDistance);
+        if(stackEntry[top] > limit) continue;
+
+        const Node& node = this->nodes[stack[top]];
+        if(node.left == 0)
+        {
+            leafTest(&this->items[node.first], node.count, hit);
+            continue;
+        }
+
+        // Both children in one batch, the nearer one is pushed last so it is visited first
+        AABB children[2] = { this->nodes[node.left].bounds, this->nodes[node.left + 1].bounds };
+        unsigned int mask = Raycast::IntersectBoxes(ray, inverseDirection, children, 2, limit, entry);
+        unsigned int nearer = entry[1] < entry[0] ? 1 : 0;
+        for(unsigned int pass = 0; pass < 2; pass++)
+        {
+            unsigned int child = pass == 0 ? 1 - nearer : nearer;
+            if(!(mask & (1u << child))) continue;
+            stack[top] = node.left + child;
+            stackEntry[top++] = entry[child];
+        }
+    }
+}
+
+#endif
@@ -3,6 +3,7 @@
 #ifndef __CAMERA_HPP__
 #define __CAMERA_HPP__
 
+#include <iostream>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -93,6 +94,14 @@ public:
         ActiveSprint = active; // Keyboard inputs should handle
     }
 
+    // points the camera along the given Euler angles, used by scripted camera paths
+    void SetOrientation(float yaw, float pitch)
+    {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(glm::vec3 direction, float deltaTime)
     {
@@ -0,0 +1,37 @@
+#include "camera_uniforms.hpp"
+
+#include <cstring>
+#include <iostream>
+
+StreamBuffer CameraUniforms::UBO;
+
+// std140 layout of the Camera block: two column-major mat4s
+static const size_t BLOCK_SIZE = 2 * sizeof(glm::mat4);
+
+void CameraUniforms::Init()
+{
+    UBO.init(GL_UNIFORM_BUFFER, BLOCK_SIZE);
+}
+
+void CameraUniforms::Update(const glm::mat4 &projection, const glm::mat4 &view)
+{
+    unsigned char *mapped = (unsigned char *)UBO.map(BLOCK_SIZE);
+    if(mapped == nullptr)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        std::cout << "ERROR::CAMERA_UNIFORMS: Failed to map the camera buffer" << std::endl;
+        return;
+    }
+    memcpy(mapped, glm::value_ptr(projection), sizeof(glm::mat4));
+    memcpy(mapped + sizeof(glm::mat4), glm::value_ptr(view), sizeof(glm::mat4));
+    UBO.unmap();
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Each frame's matrices sit at their own offset, the binding follows them
+    glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, UBO.getBuffer(), UBO.offset(), BLOCK_SIZE);
+}
+
+void CameraUniforms::Clear()
+{
+    UBO.destroy();
+}
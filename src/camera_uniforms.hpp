@@ -0,0 +1,29 @@
+#ifndef __CAMERA_UNIFORMS_HPP__
+#define __CAMERA_UNIFORMS_HPP__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader.hpp"
+#include "stream_buffer.hpp"
+
+// A static uniform buffer holding the camera matrices shared by every
+// program (std140 block CAMERA_BLOCK_NAME). It is written once per frame
+// instead of uploading view and projection for every object, into a
+// StreamBuffer so the write never waits on the previous frame's draws.
+class CameraUniforms
+{
+public:
+    // creates the buffer and attaches it to CAMERA_BLOCK_BINDING
+    static void Init();
+    // uploads this frame's matrices and binds them to CAMERA_BLOCK_BINDING, call once per frame before drawing
+    static void Update(const glm::mat4 &projection, const glm::mat4 &view);
+    // deletes the buffer
+    static void Clear();
+private:
+    CameraUniforms() { }
+    static StreamBuffer UBO;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "collision.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// Distances below this are treated as touching
+static const float EPSILON = 1e-6f;
+// Most push-out passes per sub-step, corners need two, more only helps with overlapping panels
+static const int MAX_RESOLVE_PASSES = 4;
+
+static glm::vec3 closestOnQuad(const CollisionQuad& quad, const glm::vec3& point)
+{
+    glm::vec3 d = point - quad.center;
+    float u = glm::clamp(glm::dot(d, quad.axisU), -quad.halfU, quad.halfU);
+    float v = glm::clamp(glm::dot(d, quad.axisV), -quad.halfV, quad.halfV);
+    return quad.center + quad.axisU * u + quad.axisV * v;
+}
+
+// Closest points between segments p1q1 and p2q2 (Ericson, Real-Time Collision Detection 5.1.9)
+static void closestSegmentSegment(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2, glm::vec3& c1, glm::vec3& c2)
+{
+    glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+    float s, t;
+
+    if(a <= EPSILON && e <= EPSILON) { s = t = 0.0f; }
+    else if(a <= EPSILON) { s = 0.0f; t = glm::clamp(f / e, 0.0f, 1.0f); }
+    else
+    {
+        float c = glm::dot(d1, r);
+        if(e <= EPSILON) { t = 0.0f; s = glm::clamp(-c / a, 0.0f, 1.0f); }
+        else
+        {
+            float b = glm::dot(d1, d2);
+            float denom = a * e - b * b;
+            s = denom != 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if(t < 0.0f) { t = 0.0f; s = glm::clamp(-c / a, 0.0f, 1.0f); }
+            else if(t > 1.0f) { t = 1.0f; s = glm::clamp((b - c) / a, 0.0f, 1.0f); }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+}
+
+// Closest points between segment ab and the quad, returns the squared distance
+static float closestSegmentQuad(const glm::vec3& a, const glm::vec3& b, const CollisionQuad& quad, glm::vec3& onSegment, glm::vec3& onQuad)
+{
+    // A segment piercing the panel touches it
+    float da = glm::dot(a - quad.center, quad.normal);
+    float db = glm::dot(b - quad.center, quad.normal);
+    if(da * db <= 0.0f && da != db)
+    {
+        glm::vec3 p = a + (b - a) * (da / (da - db));
+        glm::vec3 d = p - quad.center;
+        if(std::fabs(glm::dot(d, quad.axisU)) <= quad.halfU && std::fabs(glm::dot(d, quad.axisV)) <= quad.halfV)
+        {
+            onSegment = onQuad = p;
+            return 0.0f;
+        }
+    }
+
+    // Otherwise the closest pair involves an end point or an edge of the panel
+    float best;
+    glm::vec3 q = closestOnQuad(quad, a);
+    onSegment = a; onQuad = q;
+    best = glm::dot(a - q, a - q);
+
+    q = closestOnQuad(quad, b);
+    float distance = glm::dot(b - q, b - q);
+    if(distance < best) { best = distance; onSegment = b; onQuad = q; }
+
+    glm::vec3 u = quad.axisU * quad.halfU, v = quad.axisV * quad.halfV;
+    glm::vec3 corners[4] = { quad.center - u - v, quad.center + u - v, quad.center + u + v, quad.center - u + v };
+    for(int i = 0; i < 4; i++)
+    {
+        glm::vec3 c1, c2;
+        closestSegmentSegment(a, b, corners[i], corners[(i + 1) % 4], c1, c2);
+        distance = glm::dot(c1 - c2, c1 - c2);
+        if(distance < best) { best = distance; onSegment = c1; onQuad = c2; }
+    }
+    return best;
+}
+
+CollisionWorld::CollisionWorld(float cellSize)
+{
+    this->cellSize = cellSize;
+    this->stamp = 0;
+}
+
+void CollisionWorld::add(const CollisionQuad& quad)
+{
+    this->quads.push_back(quad);
+}
+
+glm::ivec3 CollisionWorld::cellOf(const glm::vec3& point) const
+{
+    return glm::ivec3(glm::floor(point / this->cellSize));
+}
+
+static size_t hashCell(const glm::ivec3& coord)
+{
+    return (size_t)((uint32_t)coord.x * 73856093u ^ (uint32_t)coord.y * 19349663u ^ (uint32_t)coord.z * 83492791u);
+}
+
+const CollisionWorld::Cell* CollisionWorld::findCell(const glm::ivec3& coord) const
+{
+    if(this->cells.empty()) return nullptr;
+
+    size_t mask = this->cells.size() - 1;
+    for(size_t slot = hashCell(coord) & mask; ; slot = (slot + 1) & mask)
+    {
+        const Cell& cell = this->cells[slot];
+        if(cell.count == 0) return nullptr;
+        if(cell.coord == coord) return &cell;
+    }
+}
+
+static AABB quadBounds(const CollisionQuad& quad)
+{
+    glm::vec3 u = quad.axisU * quad.halfU, v = quad.axisV * quad.halfV;
+    AABB bounds;
+    bounds.extend(quad.center - u - v);
+    bounds.extend(quad.center + u - v);
+    bounds.extend(quad.center + u + v);
+    bounds.extend(quad.center - u + v);
+    return bounds;
+}
+
+void CollisionWorld::build()
+{
+    struct Entry { glm::ivec3 coord; uint32_t quad; };
+    std::vector<Entry> entries;
+
+    for(uint32_t i = 0; i < this->quads.size(); i++)
+    {
+        AABB bounds = quadBounds(this->quads[i]);
+        glm::ivec3 low = this->cellOf(bounds.min), high = this->cellOf(bounds.max);
+        for(int x = low.x; x <= high.x; x++)
+            for(int y = low.y; y <= high.y; y++)
+                for(int z = low.z; z <= high.z; z++)
+                    entries.push_back({ glm::ivec3(x, y, z), i });
+    }
+
+    // Group the entries of each cell together
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if(a.coord.x != b.coord.x) return a.coord.x < b.coord.x;
+        if(a.coord.y != b.coord.y) return a.coord.y < b.coord.y;
+        return a.coord.z < b.coord.z;
+    });
+
+    size_t cellCount = 0;
+    for(size_t i = 0; i < entries.size(); i++)
+        if(i == 0 || !(entries[i].coord == entries[i - 1].coord)) cellCount++;
+
+    // Keep the table at most half full so probes stay short
+    size_t tableSize = 1;
+    while(tableSize < cellCount * 2) tableSize <<= 1;
+
+    Cell empty;
+    empty.coord = glm::ivec3(0, 0, 0);
+    empty.first = empty.count = 0;
+    this->cells.assign(tableSize, empty);
+    this->cellItems.resize(entries.size());
+
+    size_t mask = tableSize - 1;
+    for(size_t i = 0; i < entries.size(); )
+    {
+        size_t end = i;
+        while(end < entries.size() && entries[end].coord == entries[i].coord)
+        {
+            this->cellItems[end] = entries[end].quad;
+            end++;
+        }
+
+        size_t slot = hashCell(entries[i].coord) & mask;
+        while(this->cells[slot].count != 0) slot = (slot + 1) & mask;
+        this->cells[slot].coord = entries[i].coord;
+        this->cells[slot].first = i;
+        this->cells[slot].count = end - i;
+        i = end;
+    }
+
+    this->stamps.assign(this->quads.size(), 0);
+    this->stamp = 0;
+
+    std::cout << "[DEBUG] Built collision grid: " << this->quads.size() << " panels in " << cellCount << " cells" << std::endl;
+}
+
+void CollisionWorld::gather(const AABB& box) const
+{
+    this->candidates.clear();
+
+    // A new stamp invalidates every mark of the previous query
+    if(++this->stamp == 0)
+    {
+        std::fill(this->stamps.begin(), this->stamps.end(), 0);
+        this->stamp = 1;
+    }
+
+    glm::ivec3 low = this->cellOf(box.min), high = this->cellOf(box.max);
+    for(int x = low.x; x <= high.x; x++)
+        for(int y = low.y; y <= high.y; y++)
+            for(int z = low.z; z <= high.z; z++)
+            {
+                const Cell *cell = this->findCell(glm::ivec3(x, y, z));
+                if(!cell) continue;
+
+                for(uint32_t i = cell->first; i < cell->first + cell->count; i++)
+                {
+                    uint32_t quad = this->cellItems[i];
+                    if(this->stamps[quad] == this->stamp) continue;
+                    this->stamps[quad] = this->stamp;
+                    this->candidates.push_back(quad);
+                }
+            }
+}
+
+/**
+ * The sweep is split into sub-steps no longer than half the radius, so the
+ * capsule can never pass through a panel between two tests. After each
+ * sub-step every overlapping panel pushes the capsule out along the line
+ * between the closest points and removes the part of the remaining motion
+ * heading into it, which turns a blocked move into a slide.
+ */
+glm::vec3 CollisionWorld::move(const glm::vec3& position, const glm::vec3& motion, float radius, float height) const
+{
+    float length = glm::length(motion);
+    if(this->quads.empty() || length <= EPSILON) return position + motion;
+
+    // Every panel the capsule could reach during the move
+    AABB sweep;
+    sweep.extend(position);
+    sweep.extend(position + motion);
+    sweep.min.y -= height;
+    sweep.min -= glm::vec3(radius);
+    sweep.max += glm::vec3(radius);
+    this->gather(sweep);
+    if(this->candidates.empty()) return position + motion;
+
+    int steps = std::max(1, (int)std::ceil(length / (radius * 0.5f)));
+    glm::vec3 step = motion / (float)steps;
+    glm::vec3 current = position;
+    const glm::vec3 down = glm::vec3(0.0f, height, 0.0f);
+
+    for(int s = 0; s < steps; s++)
+    {
+        glm::vec3 previous = current;
+        current += step;
+
+        for(int pass = 0; pass < MAX_RESOLVE_PASSES; pass++)
+        {
+            bool touched = false;
+            for(uint32_t id: this->candidates)
+            {
+                const CollisionQuad& quad = this->quads[id];
+                glm::vec3 onSegment, onQuad;
+                float distanceSquared = closestSegmentQuad(current - down, current, quad, onSegment, onQuad);
+                if(distanceSquared >= radius * radius) continue;
+
+                float distance = std::sqrt(distanceSquared);
+                glm::vec3 pushDirection;
+                if(distance > EPSILON) pushDirection = (onSegment - onQuad) / distance;
+                else pushDirection = glm::dot(previous - quad.center, quad.normal) >= 0.0f ? quad.normal : -quad.normal; // Touching, back out the way we came
+
+                current += pushDirection * (radius - distance);
+
+                float into = glm::dot(step, pushDirection);
+                if(into < 0.0f) step -= pushDirection * into;
+                touched = true;
+            }
+            if(!touched) break;
+        }
+    }
+
+    return current;
+}
+
+void CollisionWorld::clear()
+{
+    this->quads.clear();
+    this->cells.clear();
+    this->cellItems.clear();
+    this->candidates.clear();
+    this->stamps.clear();
+    this->stamp = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef __COLLISION_HPP__
+#define __COLLISION_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+
+// Player capsule, a vertical segment hanging below the eye swept by a sphere
+const float PLAYER_RADIUS = 0.1f;
+const float PLAYER_HEIGHT = 0.2f; // Length of the segment below the eye
+// Edge length of a spatial hash cell, about the size of one wall panel
+const float COLLISION_CELL_SIZE = 1.0f;
+
+// A flat rectangular panel in world space
+struct CollisionQuad
+{
+    glm::vec3 center;
+    glm::vec3 normal;
+    glm::vec3 axisU, axisV; // Unit vectors along the width and height
+    float halfU, halfV;
+};
+
+// Static level geometry bucketed into a uniform spatial hash. A move only
+// looks at the panels in the cells its sweep overlaps, so the cost grows
+// with the walls near the player rather than with the level size.
+//
+// Not thread safe, queries reuse internal scratch buffers.
+class CollisionWorld
+{
+    private:
+        struct Cell
+        {
+            glm::ivec3 coord;
+            uint32_t first; // Into cellItems
+            uint32_t count; // 0 marks an empty slot
+        };
+
+        float cellSize;
+        std::vector<CollisionQuad> quads;
+        std::vector<Cell> cells; // Open addressed, power of two sized
+        std::vector<uint32_t> cellItems;
+
+        // Query scratch, a quad is a candidate once per query
+        mutable std::vector<uint32_t> candidates;
+        mutable std::vector<uint32_t> stamps;
+        mutable uint32_t stamp;
+
+        glm::ivec3 cellOf(const glm::vec3& point) const;
+        const Cell* findCell(const glm::ivec3& coord) const;
+        void gather(const AABB& box) const;
+
+    public:
+        CollisionWorld(float cellSize = COLLISION_CELL_SIZE);
+
+        // Quads can be added until build() is called
+        void add(const CollisionQuad& quad);
+        // Buckets every quad into the cells its bounds overlap
+        void build();
+        void clear();
+
+        // Sweeps the capsule from position by motion and returns where it ends up, sliding
+        // along any panel it touches instead of stopping dead
+        glm::vec3 move(const glm::vec3& position, const glm::vec3& motion, float radius = PLAYER_RADIUS, float height = PLAYER_HEIGHT) const;
+
+        size_t quadCount() const { return quads.size(); }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum::Frustum()
+{
+    // Accepts everything until a matrix is given
+    for(int i = 0; i < 8; i++)
+    {
+        nx[i] = ny[i] = nz[i] = ax[i] = ay[i] = az[i] = 0.0f;
+        w[i] = 1.0f;
+    }
+}
+
+Frustum::Frustum(const glm::mat4& m) : Frustum()
+{
+    // Rows of the matrix, glm is column major
+    glm::vec4 row[4];
+    for(int i = 0; i < 4; i++) row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    glm::vec4 planes[6] = {
+        row[3] + row[0], // left
+        row[3] - row[0], // right
+        row[3] + row[1], // bottom
+        row[3] - row[1], // top
+        row[3] + row[2], // near
+        row[3] - row[2], // far
+    };
+
+    for(int i = 0; i < 6; i++)
+    {
+        glm::vec4 plane = planes[i];
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        plane = plane / length;
+        nx[i] = plane.x; ny[i] = plane.y; nz[i] = plane.z; w[i] = plane.w;
+        ax[i] = std::fabs(plane.x); ay[i] = std::fabs(plane.y); az[i] = std::fabs(plane.z);
+    }
+}
+
+#ifdef FRUSTUM_SSE
+
+/**
+ * For a box with center c and half extent e the signed distance of its
+ * furthest point along each plane normal is n.c + |n|.e + w and of its
+ * nearest point n.c - |n|.e + w. Four planes are evaluated per pass.
+ */
+
+bool Frustum::intersects(const AABB& box) const
+{
+    glm::vec3 c = box.center(), e = box.extent();
+    __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+    __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+    __m128 zero = _mm_setzero_ps();
+
+    for(int i = 0; i < 8; i += 4)
+    {
+        __m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(nx + i), cx), _mm_mul_ps(_mm_load_ps(ny + i), cy)),
+                                   _mm_add_ps(_mm_mul_ps(_mm_load_ps(nz + i), cz), _mm_load_ps(w + i)));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(ax + i), ex), _mm_mul_ps(_mm_load_ps(ay + i), ey)),
+                                   _mm_mul_ps(_mm_load_ps(az + i), ez));
+        // Entirely behind any plane means outside
+        if(_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(center, radius), zero))) return false;
+    }
+    return true;
+}
+
+FrustumTest Frustum::classify(const AABB& box) const
+{
+    glm::vec3 c = box.center(), e = box.extent();
+    __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+    __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+    __m128 zero = _mm_setzero_ps();
+
+    int straddling = 0;
+    for(int i = 0; i < 8; i += 4)
+    {
+        __m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(nx + i), cx), _mm_mul_ps(_mm_load_ps(ny + i), cy)),
+                                   _mm_add_ps(_mm_mul_ps(_mm_load_ps(nz + i), cz), _mm_load_ps(w + i)));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(ax + i), ex), _mm_mul_ps(_mm_load_ps(ay + i), ey)),
+                                   _mm_mul_ps(_mm_load_ps(az + i), ez));
+        if(_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(center, radius), zero))) return FRUSTUM_OUTSIDE;
+        straddling |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(center, radius), zero));
+    }
+    return straddling ? FRUSTUM_INTERSECTS : FRUSTUM_INSIDE;
+}
+
+#else
+
+bool Frustum::intersects(const AABB& box) const
+{
+    return classify(box) != FRUSTUM_OUTSIDE;
+}
+
+FrustumTest Frustum::classify(const AABB& box) const
+{
+    glm::vec3 c = box.center(), e = box.extent();
+    bool straddling = false;
+    for(int i = 0; i < 6; i++)
+    {
+        float center = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + w[i];
+        float radius = ax[i] * e.x + ay[i] * e.y + az[i] * e.z;
+        if(center + radius < 0.0f) return FRUSTUM_OUTSIDE;
+        if(center - radius < 0.0f) straddling = true;
+    }
+    return straddling ? FRUSTUM_INTERSECTS : FRUSTUM_INSIDE;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __FRUSTUM_HPP__
+#define __FRUSTUM_HPP__
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box in world space
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    AABB() : min(1e30f), max(-1e30f) { }
+    AABB(glm::vec3 min, glm::vec3 max) : min(min), max(max) { }
+
+    void extend(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+    void extend(const AABB& box) { min = glm::min(min, box.min); max = glm::max(max, box.max); }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extent() const { return (max - min) * 0.5f; }
+    bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+};
+
+// Result of testing a box against the frustum
+enum FrustumTest
+{
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE,
+};
+
+// The six clip planes of a view-projection matrix, stored structure of
+// arrays (padded to 8 planes) so a box is tested against four planes per
+// SSE instruction.
+class Frustum
+{
+    private:
+        // plane i: nx*x + ny*y + nz*z + w >= 0 inside. Planes 6 and 7 always pass
+        alignas(16) float nx[8], ny[8], nz[8], w[8];
+        // |n| per plane, for the center/extent form of the box test
+        alignas(16) float ax[8], ay[8], az[8];
+
+    public:
+        Frustum();
+        // Gribb/Hartmann plane extraction from projection * view
+        Frustum(const glm::mat4& viewProjection);
+
+        // Cheap reject test, true if the box may be visible
+        bool intersects(const AABB& box) const;
+        // Full classification, lets hierarchy traversal stop testing fully visible subtrees
+        FrustumTest classify(const AABB& box) const;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "gl_ext.hpp"
+
+#include <iostream>
+
+int  GLExt::Major = 3;
+int  GLExt::Minor = 3;
+bool GLExt::TextureCompressionS3TC = false;
+bool GLExt::ProgramBinary = false;
+bool GLExt::MultiDrawIndirect = false;
+bool GLExt::BufferStorage = false;
+PFNGLEXTGETPROGRAMBINARYPROC   GLExt::GetProgramBinary = nullptr;
+PFNGLEXTPROGRAMBINARYPROC      GLExt::ProgramBinaryLoad = nullptr;
+PFNGLEXTPROGRAMPARAMETERIPROC  GLExt::ProgramParameteri = nullptr;
+PFNGLEXTBUFFERSTORAGEPROC GLExt::BufferStorageAlloc = nullptr;
+PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC GLExt::MultiDrawElementsIndirect = nullptr;
+std::unordered_set<std::string> GLExt::extensions;
+
+// true if the context is at least the given core version
+static bool atLeast(int major, int minor)
+{
+    return GLExt::Major > major || (GLExt::Major == major && GLExt::Minor >= minor);
+}
+
+void GLExt::Init(GLADloadproc load)
+{
+    glGetIntegerv(GL_MAJOR_VERSION, &Major);
+    glGetIntegerv(GL_MINOR_VERSION, &Minor);
+
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    extensions.clear();
+    for(int i = 0; i < count; i++)
+        extensions.insert((const char *)glGetStringi(GL_EXTENSIONS, i));
+
+    TextureCompressionS3TC = Has("GL_EXT_texture_compression_s3tc");
+
+    if(atLeast(4, 1) || Has("GL_ARB_get_program_binary"))
+    {
+        GetProgramBinary  = (PFNGLEXTGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+        ProgramBinaryLoad = (PFNGLEXTPROGRAMBINARYPROC)load("glProgramBinary");
+        ProgramParameteri = (PFNGLEXTPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+        int formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        ProgramBinary = GetProgramBinary && ProgramBinaryLoad && ProgramParameteri && formats > 0;
+    }
+
+    // the extension builds on ARB_draw_indirect, which brought the indirect buffer binding
+    if(atLeast(4, 3) || (Has("GL_ARB_multi_draw_indirect") && (atLeast(4, 0) || Has("GL_ARB_draw_indirect"))))
+    {
+        MultiDrawElementsIndirect = (PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+        MultiDrawIndirect = MultiDrawElementsIndirect != nullptr;
+    }
+
+    if(atLeast(4, 4) || Has("GL_ARB_buffer_storage"))
+    {
+        BufferStorageAlloc = (PFNGLEXTBUFFERSTORAGEPROC)load("glBufferStorage");
+        BufferStorage = BufferStorageAlloc != nullptr;
+    }
+
+    std::cout << "[DEBUG] OpenGL " << Major << "." << Minor << " on " << (const char *)glGetString(GL_RENDERER)
+              << ", " << count << " extensions, S3TC: " << TextureCompressionS3TC << ", program binary: " << ProgramBinary
+              << ", multi draw indirect: " << MultiDrawIndirect << ", buffer storage: " << BufferStorage << std::endl;
+}
+
+bool GLExt::Has(const char *extension)
+{
+    return extensions.count(extension) != 0;
+}
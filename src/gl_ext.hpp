@@ -0,0 +1,64 @@
+#ifndef __GL_EXT_HPP__
+#define __GL_EXT_HPP__
+
+#include <string>
+#include <unordered_set>
+
+#include <glad/glad.h>
+
+// GLAD is generated for core 3.3 without extensions, tokens of the
+// optional features we probe for at runtime are defined here
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// Entry points above 3.3, loaded by GLExt::Init and null when unsupported
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+
+// A static registry of the context's version and extensions, filled once
+// after GLAD has loaded. Optional fast paths check the flags here and
+// fall back to plain 3.3 core when a feature is missing.
+class GLExt
+{
+public:
+    // queries the context and loads the optional entry points, call once after gladLoadGLLoader with the same loader
+    static void Init(GLADloadproc load);
+    // true if the context advertises the extension
+    static bool Has(const char *extension);
+
+    static int  Major, Minor;
+    static bool TextureCompressionS3TC;
+    static bool ProgramBinary; // GL 4.1 or ARB_get_program_binary, with at least one binary format
+    static bool MultiDrawIndirect; // GL 4.3 or ARB_multi_draw_indirect
+    static bool BufferStorage; // GL 4.4 or ARB_buffer_storage, allows persistently mapped buffers
+
+    // GL_ARB_get_program_binary
+    static PFNGLEXTGETPROGRAMBINARYPROC   GetProgramBinary;
+    static PFNGLEXTPROGRAMBINARYPROC      ProgramBinaryLoad;
+    static PFNGLEXTPROGRAMPARAMETERIPROC  ProgramParameteri;
+    // GL_ARB_buffer_storage
+    static PFNGLEXTBUFFERSTORAGEPROC BufferStorageAlloc;
+    // GL_ARB_multi_draw_indirect
+    static PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+private:
+    GLExt() { }
+    static std::unordered_set<std::string> extensions;
+};
+
+#endif
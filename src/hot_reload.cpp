@@ -0,0 +1,159 @@
+#include "hot_reload.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "resource_mgr.hpp"
+#include "render_queue.hpp"
+#include "material_array.hpp"
+
+int HotReload::inotify = -1;
+std::unordered_map<int, std::string> HotReload::directories;
+std::unordered_map<std::string, int> HotReload::directoryWatches;
+std::unordered_map<std::string, std::vector<HotReload::Watched>> HotReload::files;
+unsigned int HotReload::watchedShaders = 0;
+unsigned int HotReload::watchedTextures = 0;
+std::vector<HotReload::WatchedArray> HotReload::materialArrays;
+
+// A save shows up as the file being closed after writing, or as another file renamed over it
+static const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+bool HotReload::Init()
+{
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify == -1)
+    {
+        std::cout << "ERROR::HOT_RELOAD: inotify unavailable, resources will not be reloaded" << std::endl;
+        return false;
+    }
+    watchNewResources();
+    return true;
+}
+
+void HotReload::Update()
+{
+    if(inotify == -1) return;
+    watchNewResources();
+
+    // Collect every changed resource first, one save can produce several events for the same file
+    std::vector<unsigned int> shaders, textures;
+    std::vector<std::pair<unsigned int, uint32_t>> materials;
+    alignas(struct inotify_event) char buffer[HOT_RELOAD_EVENT_BUFFER];
+    ssize_t length;
+    while((length = read(inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for(char *pointer = buffer; pointer < buffer + length; )
+        {
+            const struct inotify_event *event = (const struct inotify_event *)pointer;
+            pointer += sizeof(struct inotify_event) + event->len;
+            if(event->len == 0) continue;
+
+            auto directory = directories.find(event->wd);
+            if(directory == directories.end()) continue;
+            auto file = files.find(directory->second + "/" + event->name);
+            if(file == files.end()) continue;
+
+            for(const Watched &watched: file->second)
+            {
+                if(watched.kind == RELOAD_MATERIAL)
+                {
+                    std::pair<unsigned int, uint32_t> material(watched.handle, watched.material);
+                    if(std::find(materials.begin(), materials.end(), material) == materials.end())
+                        materials.push_back(material);
+                    continue;
+                }
+                std::vector<unsigned int> &changed = watched.kind == RELOAD_SHADER ? shaders : textures;
+                if(std::find(changed.begin(), changed.end(), watched.handle) == changed.end())
+                    changed.push_back(watched.handle);
+            }
+        }
+    }
+
+    for(unsigned int handle: shaders) ResourceManager::ReloadShader(handle);
+    for(unsigned int handle: textures) ResourceManager::ReloadTexture(handle);
+    for(const auto &material: materials)
+    {
+        MaterialArray *array = materialArrays[material.first].array;
+        if(array) array->reload(material.second);
+    }
+
+    // A new program may reuse the name of one just deleted, never trust the cached binding
+    if(!shaders.empty()) RenderState::Reset();
+}
+
+void HotReload::Clear()
+{
+    if(inotify != -1) close(inotify);
+    inotify = -1;
+    directories.clear();
+    directoryWatches.clear();
+    files.clear();
+    watchedShaders = 0;
+    watchedTextures = 0;
+    materialArrays.clear();
+}
+
+void HotReload::WatchMaterials(MaterialArray *materials)
+{
+    materialArrays.push_back({ materials, false });
+}
+
+void HotReload::UnwatchMaterials(MaterialArray *materials)
+{
+    // Slots are never reused, pending events may still name them
+    for(WatchedArray &watched: materialArrays)
+        if(watched.array == materials) watched.array = nullptr;
+}
+
+void HotReload::watchNewResources()
+{
+    // ResourceManager::Clear() starts the handles over
+    if(watchedShaders > ResourceManager::ShaderSources.size() || watchedTextures > ResourceManager::TextureSources.size())
+    {
+        files.clear();
+        watchedShaders = 0;
+        watchedTextures = 0;
+        for(WatchedArray &watched: materialArrays) watched.watching = false;
+    }
+
+    for(; watchedShaders < ResourceManager::ShaderSources.size(); watchedShaders++)
+    {
+        const ShaderSource &source = ResourceManager::ShaderSources[watchedShaders];
+        watch(source.vertex, RELOAD_SHADER, watchedShaders);
+        watch(source.fragment, RELOAD_SHADER, watchedShaders);
+        if(!source.geometry.empty()) watch(source.geometry, RELOAD_SHADER, watchedShaders);
+    }
+    for(; watchedTextures < ResourceManager::TextureSources.size(); watchedTextures++)
+        watch(ResourceManager::TextureSources[watchedTextures].file, RELOAD_TEXTURE, watchedTextures);
+
+    for(unsigned int i = 0; i < materialArrays.size(); i++)
+    {
+        WatchedArray &watched = materialArrays[i];
+        if(watched.array == nullptr || watched.watching) continue;
+        for(uint32_t material = 0; material < watched.array->materialCount(); material++)
+            watch(watched.array->getFile(material), RELOAD_MATERIAL, i, material);
+        watched.watching = true;
+    }
+}
+
+void HotReload::watch(const std::string &file, ResourceKind kind, unsigned int handle, uint32_t material)
+{
+    size_t slash = file.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : file.substr(0, slash);
+    std::string name = slash == std::string::npos ? file : file.substr(slash + 1);
+
+    if(directoryWatches.find(directory) == directoryWatches.end())
+    {
+        int wd = inotify_add_watch(inotify, directory.c_str(), WATCH_EVENTS);
+        if(wd == -1)
+        {
+            std::cout << "ERROR::HOT_RELOAD: Cannot watch " << directory << std::endl;
+            return;
+        }
+        directories[wd] = directory;
+        directoryWatches[directory] = wd;
+    }
+    files[directory + "/" + name].push_back({ kind, handle, material });
+}
@@ -0,0 +1,76 @@
+#ifndef __HOT_RELOAD_HPP__
+#define __HOT_RELOAD_HPP__
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+class MaterialArray;
+
+// Size of the buffer inotify events are drained into each Update(), more events wait for the next frame
+const unsigned int HOT_RELOAD_EVENT_BUFFER = 4096;
+
+/**
+ * A static watcher rebuilding resources whose files change on disk, so
+ * shaders and textures can be edited while the game runs.
+ *
+ * Every file a shader or texture was loaded from is watched through
+ * inotify on its directory (editors often save by writing a new file and
+ * renaming it over the old one, which a watch on the file itself would
+ * lose). Update() drains the events without blocking and rebuilds only the
+ * resources touching a changed file, once each however many events a save
+ * produced:
+ *   shader   recompiled and swapped in under the same handle, uniform
+ *            handles stay valid and a broken edit keeps the old program
+ *   texture  decoded on a loader thread and uploaded into the same
+ *            texture object
+ *   material reloaded into its MaterialArray region, or the array is
+ *            repacked if it no longer fits (see MaterialArray::reload)
+ * Resources loaded after Init() are picked up by the next Update(),
+ * material arrays have to be registered with WatchMaterials().
+ */
+class HotReload
+{
+public:
+    // false if inotify is unavailable, Update() then does nothing
+    static bool Init();
+    // watches newly loaded resources and rebuilds changed ones, call once per frame from the GL thread
+    static void Update();
+    // closes the inotify descriptor
+    static void Clear();
+    // reloads the array's materials when their files change, until UnwatchMaterials(). Can be called before Init()
+    static void WatchMaterials(MaterialArray *materials);
+    static void UnwatchMaterials(MaterialArray *materials);
+private:
+    HotReload() { }
+
+    enum ResourceKind { RELOAD_SHADER, RELOAD_TEXTURE, RELOAD_MATERIAL };
+    struct Watched
+    {
+        ResourceKind kind;
+        unsigned int handle; // for materials the index into materialArrays
+        uint32_t material;   // material index within that array
+    };
+    struct WatchedArray
+    {
+        MaterialArray *array; // nullptr once unwatched
+        bool watching;        // its files have been added
+    };
+
+    static int inotify;
+    // watch descriptor -> directory, and back
+    static std::unordered_map<int, std::string> directories;
+    static std::unordered_map<std::string, int> directoryWatches;
+    // "directory/name" -> resources built from that file
+    static std::unordered_map<std::string, std::vector<Watched>> files;
+    // resources already watched, handles are dense so a count is enough
+    static unsigned int watchedShaders, watchedTextures;
+    static std::vector<WatchedArray> materialArrays;
+
+    // starts watching any resources loaded since the last call
+    static void watchNewResources();
+    static void watch(const std::string &file, ResourceKind kind, unsigned int handle, uint32_t material = 0);
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "instanced_mesh.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// First attribute location used by the per-instance data
+static const unsigned int INSTANCE_ATTRIB = 2;
+
+// Instances carry their own transform, the model uniform is unused
+static const glm::mat4 IDENTITY = glm::mat4(1.0f);
+
+InstancedMesh::InstancedMesh(const ObjectModel& prototype)
+{
+    this->shader = prototype.getShader();
+    this->texture = prototype.getTexture();
+    this->useTexture = prototype.usesTexture();
+    this->capacity = 0;
+    this->dirty = false;
+    this->uploadedFrame = ~0u;
+
+    if(this->shader == INVALID_HANDLE) throw std::runtime_error("Instanced mesh prototype has no shader loaded");
+
+    const std::vector<float>& vertices = prototype.getVertices();
+    const std::vector<unsigned int>& indices = prototype.getIndices();
+    if(indices.empty()) throw std::runtime_error("Instanced meshes should use element buffers");
+    this->indexCount = indices.size();
+
+    // The prototype's geometry packs like any model, instance data stays in full floats
+    PackedMesh mesh = MeshPacker::Pack(vertices.data(), vertices.size() / FLOATS_PER_VERTEX, MODEL_VERTEX_LAYOUT, MODEL_VERTEX_ELEMENTS,
+                                       indices.data(), indices.size());
+    this->indexType = mesh.indexType;
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->EBO);
+
+    RenderState::BindVertexArray(this->VAO);
+    MeshPacker::Upload(mesh, this->VBO, this->EBO);
+
+    // Per-instance attributes advance once per instance instead of once per vertex, they are
+    // pointed at the instance buffer on every upload since each frame writes its own section
+    for(unsigned int location = INSTANCE_ATTRIB; location <= INSTANCE_ATTRIB + 4; location++)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    RenderState::BindVertexArray(0);
+}
+
+void InstancedMesh::bindInstanceAttributes(size_t offset)
+{
+    RenderState::BindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer.getBuffer());
+    const size_t instanceStride = sizeof(InstanceData);
+    for(unsigned int column = 0; column < 4; column++)
+    {
+        unsigned int location = INSTANCE_ATTRIB + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, instanceStride, (void *) (offset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(INSTANCE_ATTRIB + 4, 1, GL_FLOAT, GL_FALSE, instanceStride, (void *) (offset + offsetof(InstanceData, layer)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int InstancedMesh::addInstance(const glm::mat4& model, float layer)
+{
+    InstanceData instance;
+    instance.model = model;
+    instance.layer = layer;
+    this->instances.push_back(instance);
+    this->dirty = true;
+    return this->instances.size() - 1;
+}
+
+void InstancedMesh::setInstance(unsigned int index, const glm::mat4& model, float layer)
+{
+    this->instances[index].model = model;
+    this->instances[index].layer = layer;
+    this->dirty = true;
+}
+
+void InstancedMesh::clearInstances()
+{
+    this->instances.clear();
+    this->dirty = true;
+}
+
+void InstancedMesh::upload()
+{
+    // Drawing the attributes' old section in a later frame would race with that section being
+    // rewritten STREAM_BUFFER_FRAMES frames after it was filled, only its own frame may read it
+    if(!this->dirty && this->uploadedFrame == StreamBuffer::CurrentFrame()) return;
+
+    if(this->instances.size() > this->capacity)
+    {
+        // Grow geometrically so spawning a few instances does not reallocate every time
+        this->capacity = std::max<unsigned int>(this->instances.size(), this->capacity * 2);
+        this->instanceBuffer.init(GL_ARRAY_BUFFER, this->capacity * sizeof(InstanceData));
+    }
+
+    size_t size = this->instances.size() * sizeof(InstanceData);
+    void *mapped = this->instanceBuffer.map(size);
+    if(mapped == nullptr)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::cout << "ERROR::INSTANCED_MESH: Failed to map the instance buffer" << std::endl;
+        return;
+    }
+    memcpy(mapped, this->instances.data(), size);
+    this->instanceBuffer.unmap();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->bindInstanceAttributes(this->instanceBuffer.offset());
+    this->dirty = false;
+    this->uploadedFrame = StreamBuffer::CurrentFrame();
+}
+
+void InstancedMesh::draw()
+{
+    if(this->instances.empty()) return;
+    this->upload();
+
+    RenderState::UseProgram(ResourceManager::GetShader(this->shader).ID);
+    if(this->useTexture) RenderState::BindTexture(0, ResourceManager::GetTexture(this->texture).ID);
+    RenderState::BindVertexArray(this->VAO);
+
+    glDrawElementsInstanced(GL_TRIANGLES, this->indexCount, this->indexType, 0, this->instances.size());
+}
+
+void InstancedMesh::submit(RenderQueue& queue)
+{
+    if(this->instances.empty()) return;
+    this->upload();
+
+    DrawItem item;
+    item.shader = this->shader;
+    item.texture = this->useTexture ? this->texture : INVALID_HANDLE;
+    item.VAO = this->VAO;
+    item.indexCount = this->indexCount;
+    item.firstIndex = 0;
+    item.instanceCount = this->instances.size();
+    item.indexType = this->indexType;
+    item.model = &IDENTITY;
+
+    // Instances are spread over the level, they have no single depth
+    queue.submit(item, 0.0f);
+}
+
+void InstancedMesh::destroy()
+{
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    glDeleteBuffers(1, &this->EBO);
+    this->instanceBuffer.destroy();
+    this->instances.clear();
+    this->capacity = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef __INSTANCED_MESH_HPP__
+#define __INSTANCED_MESH_HPP__
+
+#include <vector>
+#include <stdexcept>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "resource_mgr.hpp"
+#include "object_model.hpp"
+#include "render_queue.hpp"
+#include "stream_buffer.hpp"
+
+// Per-instance attributes, matches the layout in shaders/instanced.vs
+struct InstanceData
+{
+    glm::mat4 model; // locations 2..5, one column each
+    float layer;     // location 6, texture layer of this instance
+};
+
+// One copy of a mesh on the GPU drawn many times with
+// glDrawElementsInstanced. The geometry, shader and texture come from a
+// prototype ObjectModel, every instance only adds its transform and
+// texture layer to the instance buffer, a StreamBuffer so instances can
+// be rewritten every frame without waiting on the GPU.
+class InstancedMesh
+{
+    private:
+        ShaderHandle shader;
+        TextureHandle texture;
+        bool useTexture;
+
+        unsigned int VAO, VBO, EBO;
+        StreamBuffer instanceBuffer;
+        unsigned int indexCount;
+        GLenum indexType;
+        unsigned int capacity; // Instances the GPU buffer can hold per frame without reallocating
+        bool dirty; // Instance data changed since the last upload
+        unsigned int uploadedFrame; // StreamBuffer frame the attributes point into
+
+        // Points the instance attributes at the given byte offset of the instance buffer
+        void bindInstanceAttributes(size_t offset);
+
+        std::vector<InstanceData> instances;
+
+    public:
+        // Uploads the prototype's geometry, which must already have its resources loaded
+        InstancedMesh(const ObjectModel& prototype);
+
+        // Instance editing, changes reach the GPU on the next upload()
+        unsigned int addInstance(const glm::mat4& model, float layer = 0.0f);
+        void setInstance(unsigned int index, const glm::mat4& model, float layer = 0.0f);
+        void clearInstances();
+        unsigned int instanceCount() const { return instances.size(); }
+
+        // Copies the instance data into this frame's section of the instance buffer. Done every frame even
+        // if nothing changed, the section written earlier is reused once the ring comes around to it
+        void upload();
+        // Draws every instance with a single call
+        void draw();
+        // Queues every instance as a single draw item
+        void submit(RenderQueue& queue);
+        // Deletes the GL buffers, must be called while the context is alive
+        void destroy();
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "latency.hpp"
+
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+bool Latency::Enabled = false;
+bool Latency::LowLatency = false;
+Latency::Frame Latency::frames[LATENCY_HISTORY];
+unsigned int Latency::frame = 0;
+double Latency::shownUpTo = 0.0;
+Latency::Interval Latency::toSimulated = { 0.0, 0.0 };
+Latency::Interval Latency::toSubmitted = { 0.0, 0.0 };
+Latency::Interval Latency::toSwapped = { 0.0, 0.0 };
+Latency::Interval Latency::toGpu = { 0.0, 0.0 };
+unsigned int Latency::samples = 0;
+double Latency::lastReport = 0.0;
+
+// Waiting longer than this for a frame means the GPU is gone, give up rather than hang
+static const GLuint64 FENCE_TIMEOUT = 100000000; // 100 ms in nanoseconds
+
+void Latency::Init()
+{
+    for(unsigned int i = 0; i < LATENCY_HISTORY; i++)
+    {
+        glGenQueries(1, &frames[i].query);
+        frames[i].fence = nullptr;
+    }
+    frame = 0;
+    shownUpTo = 0.0;
+    lastReport = glfwGetTime();
+}
+
+bool Latency::resolve(Frame& record, bool wait)
+{
+    if(!record.fence) return true;
+
+    GLenum status = glClientWaitSync(record.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? FENCE_TIMEOUT : 0);
+    if(status == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(record.fence);
+    record.fence = nullptr;
+
+    // Frames without new input have no latency to report
+    if(record.input < 0.0 || status == GL_WAIT_FAILED) return true;
+
+    // Place the GPU timestamp on the CPU clock through a pair of readings taken now
+    GLuint64 gpuDone;
+    GLint64 gpuNow;
+    glGetQueryObjectui64v(record.query, GL_QUERY_RESULT, &gpuDone);
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    double gpu = glfwGetTime() - (double) (gpuNow - (GLint64) gpuDone) * 1e-9;
+
+    toSimulated.add(record.simulated - record.input);
+    toSubmitted.add(record.submitted - record.input);
+    toSwapped.add(record.swapped - record.input);
+    toGpu.add(gpu - record.input);
+    samples++;
+    return true;
+}
+
+void Latency::BeginFrame()
+{
+    // Collect whatever finished without waiting
+    for(unsigned int i = 0; i < LATENCY_HISTORY; i++) resolve(frames[i], false);
+
+    // Hold the CPU back until at most the allowed number of frames are queued
+    if(LowLatency && frame >= LOW_LATENCY_FRAMES_IN_FLIGHT)
+        resolve(frames[(frame - LOW_LATENCY_FRAMES_IN_FLIGHT) % LATENCY_HISTORY], true);
+
+    // The slot about to be reused must be resolved, it is LATENCY_HISTORY frames old
+    Frame& record = frames[frame % LATENCY_HISTORY];
+    if(!resolve(record, true))
+    {
+        // Give up on that frame, MarkSwapped is about to place a new fence in the slot
+        std::cout << "ERROR::LATENCY: Gave up waiting for frame " << frame - LATENCY_HISTORY << ", dropping it" << std::endl;
+        glDeleteSync(record.fence);
+        record.fence = nullptr;
+    }
+    record.input = record.simulated = record.submitted = record.swapped = -1.0;
+
+    double now = glfwGetTime();
+    if(Enabled && now - lastReport >= LATENCY_REPORT_INTERVAL) report(now);
+}
+
+void Latency::MarkInput(double oldest, double newest)
+{
+    if(newest <= shownUpTo) return;
+
+    // Events up to shownUpTo already appeared in an earlier frame
+    double first = std::max(oldest, shownUpTo);
+    Frame& record = frames[frame % LATENCY_HISTORY];
+    if(record.input < 0.0 || first < record.input) record.input = first;
+    shownUpTo = newest;
+}
+
+void Latency::MarkSimulated()
+{
+    frames[frame % LATENCY_HISTORY].simulated = glfwGetTime();
+}
+
+void Latency::MarkSubmitted()
+{
+    Frame& record = frames[frame % LATENCY_HISTORY];
+    record.submitted = glfwGetTime();
+    glQueryCounter(record.query, GL_TIMESTAMP);
+}
+
+void Latency::MarkSwapped()
+{
+    Frame& record = frames[frame % LATENCY_HISTORY];
+    record.swapped = glfwGetTime();
+    record.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame++;
+}
+
+void Latency::report(double now)
+{
+    if(samples > 0)
+    {
+        std::cout << std::fixed << std::setprecision(2)
+                  << "[DEBUG] Latency ms (avg/max, from event poll) over " << samples << " frames"
+                  << (LowLatency ? ", low latency" : "")
+                  << ": sim " << toSimulated.sum / samples * 1000.0 << "/" << toSimulated.max * 1000.0
+                  << ", submit " << toSubmitted.sum / samples * 1000.0 << "/" << toSubmitted.max * 1000.0
+                  << ", swap " << toSwapped.sum / samples * 1000.0 << "/" << toSwapped.max * 1000.0
+                  << ", gpu " << toGpu.sum / samples * 1000.0 << "/" << toGpu.max * 1000.0
+                  << std::defaultfloat << std::endl;
+    }
+
+    toSimulated = toSubmitted = toSwapped = toGpu = { 0.0, 0.0 };
+    samples = 0;
+    lastReport = now;
+}
+
+void Latency::Clear()
+{
+    for(unsigned int i = 0; i < LATENCY_HISTORY; i++)
+    {
+        if(frames[i].fence) glDeleteSync(frames[i].fence);
+        frames[i].fence = nullptr;
+        glDeleteQueries(1, &frames[i].query);
+        frames[i].query = 0;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef __LATENCY_HPP__
+#define __LATENCY_HPP__
+
+#include <glad/glad.h>
+
+// Frames whose latency is tracked at once, also the most frames in flight that can be limited to
+const unsigned int LATENCY_HISTORY = 8;
+// Frames in flight allowed in low latency mode, 1 means the CPU waits for the previous frame's GPU work
+const unsigned int LOW_LATENCY_FRAMES_IN_FLIGHT = 1;
+// Seconds between latency reports
+const double LATENCY_REPORT_INTERVAL = 1.0;
+
+/**
+ * A static input to photon latency tracker. Every frame records, on the
+ * glfwGetTime() clock:
+ *   input      poll time of the oldest mouse event first shown this frame
+ *   simulated  simulation ticks done
+ *   submitted  draw calls issued, a GL_TIMESTAMP query is placed here
+ *   swapped    glfwSwapBuffers returned, a fence is placed here
+ *   gpu        the timestamp query, converted to the CPU clock
+ * Frames are resolved once their fence signals, never stalling the GPU.
+ *
+ * GLFW gives no hardware event times, so "input" is when glfwPollEvents()
+ * dispatched the event (see MouseInput). Time an event spent queued before
+ * that poll, up to a frame, is not seen, so every figure is a lower bound.
+ *
+ * In low latency mode BeginFrame() waits on the fence of the frame
+ * LOW_LATENCY_FRAMES_IN_FLIGHT back, so the CPU cannot queue frames ahead
+ * of the GPU and the input sampled afterwards is as fresh as possible.
+ */
+class Latency
+{
+public:
+    // prints input to sim/submit/swap/gpu averages and maxima every LATENCY_REPORT_INTERVAL
+    static bool Enabled;
+    // limits frames in flight and asks the caller to sample input late
+    static bool LowLatency;
+
+    static void Init();
+    // resolves finished frames and, in low latency mode, waits for the GPU to catch up
+    static void BeginFrame();
+    // mouse events spanning oldest..newest reached the screen this frame, events already shown are ignored
+    static void MarkInput(double oldest, double newest);
+    static void MarkSimulated();
+    static void MarkSubmitted();
+    static void MarkSwapped();
+    // deletes the GL queries and fences, must be called while the context is alive
+    static void Clear();
+private:
+    Latency() { }
+
+    struct Frame
+    {
+        double input, simulated, submitted, swapped;
+        unsigned int query;
+        GLsync fence; // nullptr once resolved
+    };
+
+    // Sums and maxima of the intervals since the last report
+    struct Interval
+    {
+        double sum, max;
+        void add(double value) { sum += value; if(value > max) max = value; }
+    };
+
+    static Frame frames[LATENCY_HISTORY];
+    static unsigned int frame; // Index of the frame being recorded, counts up forever
+    static double shownUpTo;   // Newest input already on screen
+    static Interval toSimulated, toSubmitted, toSwapped, toGpu;
+    static unsigned int samples;
+    static double lastReport;
+
+    static bool resolve(Frame& frame, bool wait);
+    static void report(double now);
+};
+
+#endif
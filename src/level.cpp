@@ -0,0 +1,270 @@
+#include "level.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Bump whenever a record layout changes
+static const uint32_t LEVEL_VERSION = 1;
+static const char LEVEL_MAGIC[4] = { 'A', 'L', 'V', 'L' };
+
+// Nothing but whitespace may follow a record's fields, a stray value is most likely a typo
+static bool endOfRecord(std::istringstream& fields)
+{
+    return (fields >> std::ws).eof();
+}
+
+Level::Level()
+{
+    this->mapping = nullptr;
+    this->size = 0;
+    this->header = nullptr;
+    this->strings = nullptr;
+}
+
+Level::~Level()
+{
+    this->close();
+}
+
+bool Level::open(const std::string& file)
+{
+    this->close();
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        std::cout << "ERROR::LEVEL: Cannot open " << file << std::endl;
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(LevelHeader))
+    {
+        std::cout << "ERROR::LEVEL: " << file << " is too small to be a level" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t fileSize = info.st_size;
+    void *fileMapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(fileMapping == MAP_FAILED)
+    {
+        std::cout << "ERROR::LEVEL: Cannot map " << file << std::endl;
+        return false;
+    }
+    this->mapping = fileMapping;
+    this->size = fileSize;
+    this->header = (const LevelHeader *)fileMapping;
+
+    // Validate everything once here so the accessors never have to
+    const LevelHeader *h = this->header;
+    size_t expected = sizeof(LevelHeader)
+                    + (size_t)h->materialCount * sizeof(LevelMaterial)
+                    + (size_t)h->wallCount * sizeof(LevelWall)
+                    + (size_t)h->spawnCount * sizeof(LevelSpawn)
+                    + h->stringTableSize;
+    const char *error = nullptr;
+    if(memcmp(h->magic, LEVEL_MAGIC, 4) != 0) error = "bad magic";
+    else if(h->version != LEVEL_VERSION) error = "unsupported version, recompile it";
+    else if(expected != fileSize) error = "size does not match its header";
+    else if(h->stringTableSize == 0 || ((const char *)fileMapping)[fileSize - 1] != '\0') error = "unterminated string table";
+
+    if(error == nullptr)
+    {
+        this->strings = (const char *)fileMapping + fileSize - h->stringTableSize;
+        const LevelMaterial *materials = (const LevelMaterial *)(h + 1);
+        for(uint32_t i = 0; i < h->materialCount && !error; i++)
+            if(materials[i].shader >= h->stringTableSize || materials[i].texture >= h->stringTableSize) error = "material string out of range";
+
+        const LevelWall *wallRecords = this->walls();
+        for(uint32_t i = 0; i < h->wallCount && !error; i++)
+            if(wallRecords[i].material >= h->materialCount) error = "wall material out of range";
+    }
+
+    if(error != nullptr)
+    {
+        std::cout << "ERROR::LEVEL: " << file << ": " << error << std::endl;
+        this->close();
+        return false;
+    }
+
+    std::cout << "[DEBUG] Loaded level " << file << ": " << h->wallCount << " walls, " << h->materialCount << " materials, " << h->spawnCount << " spawns" << std::endl;
+    return true;
+}
+
+bool Level::openOrCompile(const std::string& textFile)
+{
+    std::string binaryFile = textFile;
+    size_t dot = binaryFile.rfind('.');
+    if(dot != std::string::npos) binaryFile.erase(dot);
+    binaryFile += ".lvl";
+
+    // Rebuild when the authoring file is newer than the binary
+    struct stat text, binary;
+    bool haveText = stat(textFile.c_str(), &text) == 0;
+    bool haveBinary = stat(binaryFile.c_str(), &binary) == 0;
+    if(haveText && (!haveBinary || text.st_mtime > binary.st_mtime))
+    {
+        if(!Compile(textFile, binaryFile)) return false;
+    }
+    return this->open(binaryFile);
+}
+
+void Level::close()
+{
+    if(this->mapping != nullptr) munmap(this->mapping, this->size);
+    this->mapping = nullptr;
+    this->size = 0;
+    this->header = nullptr;
+    this->strings = nullptr;
+}
+
+const char *Level::materialShader(uint32_t material) const
+{
+    return this->string(((const LevelMaterial *)(this->header + 1))[material].shader);
+}
+
+const char *Level::materialTexture(uint32_t material) const
+{
+    return this->string(((const LevelMaterial *)(this->header + 1))[material].texture);
+}
+
+const LevelWall *Level::walls() const
+{
+    return (const LevelWall *)((const LevelMaterial *)(this->header + 1) + this->header->materialCount);
+}
+
+const LevelSpawn *Level::spawns() const
+{
+    return (const LevelSpawn *)(this->walls() + this->header->wallCount);
+}
+
+bool Level::Compile(const std::string& textFile, const std::string& binaryFile)
+{
+    std::ifstream in(textFile);
+    if(!in)
+    {
+        std::cout << "ERROR::LEVEL: Cannot open " << textFile << std::endl;
+        return false;
+    }
+
+    std::vector<LevelMaterial> materials;
+    std::vector<LevelWall> wallRecords;
+    std::vector<LevelSpawn> spawnRecords;
+    std::map<std::string, uint32_t> materialNames;
+    std::string stringTable;
+
+    // Strings are stored once each
+    std::map<std::string, uint32_t> stringOffsets;
+    auto addString = [&](const std::string& text)
+    {
+        auto iter = stringOffsets.find(text);
+        if(iter != stringOffsets.end()) return iter->second;
+        uint32_t offset = stringTable.size();
+        stringTable += text;
+        stringTable += '\0';
+        stringOffsets[text] = offset;
+        return offset;
+    };
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while(std::getline(in, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if(comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string kind;
+        if(!(fields >> kind)) continue;
+
+        bool ok = true;
+        if(kind == "material")
+        {
+            std::string name, shader, texture;
+            ok = (bool)(fields >> name >> shader >> texture) && endOfRecord(fields) && materialNames.find(name) == materialNames.end();
+            if(ok)
+            {
+                materialNames[name] = materials.size();
+                materials.push_back({ addString(shader), addString(texture) });
+            }
+        }
+        else if(kind == "wall")
+        {
+            std::string material;
+            LevelWall wall;
+            ok = (bool)(fields >> material
+                              >> wall.center[0] >> wall.center[1] >> wall.center[2]
+                              >> wall.normal[0] >> wall.normal[1] >> wall.normal[2]
+                              >> wall.width >> wall.height) && endOfRecord(fields);
+            // Panels are unit quads scaled to at most the unit size, see WallModel
+            ok = ok && std::fabs(wall.width) <= 1.0f && std::fabs(wall.height) <= 1.0f;
+            auto iter = materialNames.find(material);
+            ok = ok && iter != materialNames.end();
+            if(ok)
+            {
+                wall.material = iter->second;
+                wallRecords.push_back(wall);
+            }
+        }
+        else if(kind == "spawn")
+        {
+            LevelSpawn spawn;
+            ok = (bool)(fields >> spawn.position[0] >> spawn.position[1] >> spawn.position[2] >> spawn.yaw >> spawn.pitch) && endOfRecord(fields);
+            if(ok) spawnRecords.push_back(spawn);
+        }
+        else ok = false;
+
+        if(!ok)
+        {
+            std::cout << "ERROR::LEVEL: " << textFile << ":" << lineNumber << ": cannot parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    if(stringTable.empty()) stringTable += '\0';
+    // Keep the file size a multiple of 4
+    while(stringTable.size() % 4 != 0) stringTable += '\0';
+
+    LevelHeader header;
+    memcpy(header.magic, LEVEL_MAGIC, 4);
+    header.version = LEVEL_VERSION;
+    header.materialCount = materials.size();
+    header.wallCount = wallRecords.size();
+    header.spawnCount = spawnRecords.size();
+    header.stringTableSize = stringTable.size();
+
+    // Written aside and renamed so the game never maps a half written level
+    std::string tmp = binaryFile + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)materials.data(), materials.size() * sizeof(LevelMaterial));
+        out.write((const char *)wallRecords.data(), wallRecords.size() * sizeof(LevelWall));
+        out.write((const char *)spawnRecords.data(), spawnRecords.size() * sizeof(LevelSpawn));
+        out.write(stringTable.data(), stringTable.size());
+        if(!out)
+        {
+            std::cout << "ERROR::LEVEL: Cannot write " << binaryFile << std::endl;
+            return false;
+        }
+    }
+    if(std::rename(tmp.c_str(), binaryFile.c_str()) != 0)
+    {
+        std::cout << "ERROR::LEVEL: Cannot write " << binaryFile << std::endl;
+        return false;
+    }
+
+    std::cout << "[DEBUG] Compiled level " << textFile << " -> " << binaryFile << std::endl;
+    return true;
+}
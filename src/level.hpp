@@ -0,0 +1,86 @@
+#ifndef __LEVEL_HPP__
+#define __LEVEL_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * Binary level layout (little endian, every record 4 byte aligned):
+ *   LevelHeader
+ *   LevelMaterial[materialCount]
+ *   LevelWall[wallCount]
+ *   LevelSpawn[spawnCount]
+ *   string table (NUL terminated strings referenced by offset)
+ * The file is memory mapped and the records are used in place.
+ */
+
+struct LevelHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t materialCount;
+    uint32_t wallCount;
+    uint32_t spawnCount;
+    uint32_t stringTableSize;
+};
+
+struct LevelMaterial
+{
+    uint32_t shader;  // string table offset of the shader name (without .vs/.fs)
+    uint32_t texture; // string table offset of the texture file
+};
+
+struct LevelWall
+{
+    float center[3];
+    float normal[3];
+    float width, height;
+    uint32_t material;
+};
+
+struct LevelSpawn
+{
+    float position[3];
+    float yaw, pitch;
+};
+
+// A level file mapped read-only into memory. Every accessor points into
+// the mapping, so loading does no per-element heap allocation.
+class Level
+{
+    private:
+        void *mapping;
+        size_t size;
+        const LevelHeader *header;
+        const char *strings;
+
+        const char *string(uint32_t offset) const { return strings + offset; }
+
+    public:
+        Level();
+        ~Level();
+        Level(const Level&) = delete;
+        Level& operator=(const Level&) = delete;
+
+        // Maps and validates a binary level, false (with an error printed) if it is unusable
+        bool open(const std::string& file);
+        // Opens the binary next to an authoring file (name.txt -> name.lvl), compiling it first if it is missing or older
+        bool openOrCompile(const std::string& textFile);
+        void close();
+
+        uint32_t materialCount() const { return header->materialCount; }
+        const char *materialShader(uint32_t material) const;
+        const char *materialTexture(uint32_t material) const;
+
+        uint32_t wallCount() const { return header->wallCount; }
+        const LevelWall *walls() const;
+
+        uint32_t spawnCount() const { return header->spawnCount; }
+        const LevelSpawn *spawns() const;
+
+        // Converts the text authoring form into the binary form
+        static bool Compile(const std::string& textFile, const std::string& binaryFile);
+};
+
+#endif
@@ -7,81 +7,178 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
+#include <cstring>
+#include <random>
 
 #include "window_mgr.hpp"
 #include "resource_mgr.hpp"
-#include "wall_model.hpp"
+#include "scene.hpp"
+#include "camera_uniforms.hpp"
+#include "render_queue.hpp"
+#include "profiler.hpp"
+#include "texture_loader.hpp"
 #include "camera.hpp"
+#include "simulation.hpp"
+#include "mouse_input.hpp"
+#include "latency.hpp"
+#include "targets.hpp"
+#include "session.hpp"
+#include "hot_reload.hpp"
+#include "stream_buffer.hpp"
 
 #define SCREEN_WIDTH  1366
 #define SCREEN_HEIGHT 768
 #define SCREEN_TITLE  "AIM"
+#define PROFILE_FILE  "profile.json"
+#define LEVEL_FILE    "levels/arena.txt"
+#define SESSION_FILE  "session.aimrec"
 
+// Shotgun pattern fired with the right mouse button
+#define SHOTGUN_PELLETS 17
+#define SHOTGUN_SPREAD  4.0f
+
+// Simulation rate in Hz, e.g. make run TICK_RATE=1000
+#ifndef TICK_RATE
+#define TICK_RATE DEFAULT_TICK_RATE
+#endif
 
-Camera *camera;
 
-// Time calculation for the game
-float deltaTime = 0.0f;
-float lastFrameTime = 0.0f;
-float currFrameTime = 0.0f;
+Camera *camera;
 
+// Once per rendered frame, for keys that are not part of the simulation
 void processInput(GLFWwindow* window)
 {
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
 
+    // Dump the profiler timeline once per press
+    static bool dumpHeld = false;
+    bool dumpPressed = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+    if(dumpPressed && !dumpHeld) Profiler::WriteChromeTrace(PROFILE_FILE);
+    dumpHeld = dumpPressed;
+
+    // F4 toggles the latency report, F5 the low latency mode
+    static bool reportHeld = false, lowLatencyHeld = false;
+    bool reportPressed = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+    bool lowLatencyPressed = glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS;
+    if(reportPressed && !reportHeld) Latency::Enabled = !Latency::Enabled;
+    if(lowLatencyPressed && !lowLatencyHeld)
+    {
+        Latency::LowLatency = !Latency::LowLatency;
+        std::cout << "[DEBUG] Low latency mode: " << Latency::LowLatency << std::endl;
+    }
+    reportHeld = reportPressed;
+    lowLatencyHeld = lowLatencyPressed;
+}
+
+// Casts a shot from the eye along the view direction, pellets > 1 fires a shotgun spread
+void shoot(const Scene& scene, TargetPool& targets, unsigned int pellets)
+{
+    Ray rays[SHOTGUN_PELLETS];
+    RayHit hits[SHOTGUN_PELLETS];
+    pellets = std::min<unsigned int>(pellets, SHOTGUN_PELLETS);
+
+    Ray center(camera->Position, camera->Front);
+    if(pellets > 1) Raycast::Spread(center, camera->Up, SHOTGUN_SPREAD, rays, pellets);
+    else rays[0] = center;
+
+    // Walls first, a target is only hit if it is closer than the wall behind it
+    scene.raycast(rays, pellets, hits);
+    targets.raycast(rays, pellets, hits);
+
+    for(unsigned int i = 0; i < pellets; i++)
+    {
+        if(hits[i].kind == HIT_TARGET && targets.hit(hits[i].id))
+            std::cout << "[DEBUG] Target hit at " << hits[i].distance << ", score " << targets.hits << "/" << targets.hits + targets.misses << std::endl;
+    }
+}
+
+// Everything the simulation reads from the devices for the tick ending at tickEnd
+TickInput sampleInput(GLFWwindow* window, double tickEnd)
+{
+    TickInput input;
+    input.keys = 0;
+    input.dx = input.dy = 0.0f;
+
+    // Mouse motion polled up to the end of this tick turns the camera once. Stamps are poll
+    // times, so a frame's motion lands in one tick rather than being split by when it happened
+    MouseMotion motion = MouseInput::Consume(tickEnd);
+    if(motion.count > 0)
+    {
+        input.dx = motion.dx;
+        input.dy = motion.dy;
+        Latency::MarkInput(motion.oldest, motion.newest);
+    }
+
+    if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) input.keys |= TICK_FORWARD;
+    if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) input.keys |= TICK_BACKWARD;
+    if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) input.keys |= TICK_LEFT;
+    if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) input.keys |= TICK_RIGHT;
+    if(glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) input.keys |= TICK_SPRINT;
+    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) input.keys |= TICK_FIRE;
+    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) input.keys |= TICK_SHOTGUN;
+    return input;
+}
+
+// Advances the player and targets by one fixed tick of dt seconds. Depends on nothing but
+// the input and the previous state, so a recorded session replays exactly
+void simulateTick(const TickInput& input, const Scene& scene, TargetPool& targets, float dt)
+{
+    targets.update(dt);
+
+    if(input.dx != 0.0f || input.dy != 0.0f) camera->ProcessMouseMovement(input.dx, input.dy, true);
+
     // Abstracting the directions from the keys so that sprinting is balanced
     glm::vec3 direction(0.0f); 
 
-    if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if(input.keys & TICK_FORWARD)
     {
         direction += camera->Front; // Forward
     }
-    if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if(input.keys & TICK_BACKWARD)
     {
         direction -= camera->Front; // Backward
     }
-    if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if(input.keys & TICK_LEFT)
     {
         direction -= camera->Right; // Left
     }
-    if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if(input.keys & TICK_RIGHT)
     {
         direction += camera->Right; // Right
     }
 
     // handle sprinting
-    if(glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS )
-    {
-        camera->ActivateSprint( true );
-    }
-    if(glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE )
-    {
-        camera->ActivateSprint( false );
-    }
-
-    // Pass the direction to the camera
-    camera->ProcessKeyboard(direction, deltaTime);
+    camera->ActivateSprint( (input.keys & TICK_SPRINT) != 0 );
+
+    // Pass the direction to the camera, then keep the move inside the room
+    glm::vec3 start = camera->Position;
+    camera->ProcessKeyboard(direction, dt);
+    camera->Position = scene.collision.move(start, camera->Position - start);
+
+    // Fire on the tick the button goes down, after moving so the shot leaves from where the player now is
+    static bool fireHeld = false, shotgunHeld = false;
+    bool firePressed = (input.keys & TICK_FIRE) != 0;
+    bool shotgunPressed = (input.keys & TICK_SHOTGUN) != 0;
+    if(firePressed && !fireHeld) shoot(scene, targets, 1);
+    if(shotgunPressed && !shotgunHeld) shoot(scene, targets, SHOTGUN_PELLETS);
+    fireHeld = firePressed;
+    shotgunHeld = shotgunPressed;
 }
 
-// Handle the mouse movements
-bool firstPos = true;
-float lastX, lastY;
-void mouse_movement_callback(GLFWwindow* window, double xpos, double ypos)
+// The state a replay has to reproduce
+SessionResult captureResult(const TargetPool& targets)
 {
-    if(firstPos)
-    {
-        lastX = xpos;
-        lastY = xpos;
-        firstPos = false;
-    }
-
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos; 
-    lastX = xpos;
-    lastY = ypos;
-
-    camera->ProcessMouseMovement(xoffset, yoffset, true);
+    SessionResult result;
+    std::memset(&result, 0, sizeof(result));
+    result.position[0] = camera->Position.x;
+    result.position[1] = camera->Position.y;
+    result.position[2] = camera->Position.z;
+    result.yaw = camera->Yaw;
+    result.pitch = camera->Pitch;
+    result.hits = targets.hits;
+    result.misses = targets.misses;
+    return result;
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
@@ -90,13 +187,46 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 }
 
 
-int32_t main()
+int32_t main(int argc, char** argv)
 {
     std::cout << "[DEBUG] Hello World!" << std::endl;
 
+    // Every session is recorded unless told otherwise, or replayed from a log
+    const char* recordFile = SESSION_FILE;
+    const char* replayFile = nullptr;
+    bool headless = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--record") && i + 1 < argc) recordFile = argv[++i];
+        else if(!strcmp(argv[i], "--no-record")) recordFile = nullptr;
+        else if(!strcmp(argv[i], "--replay") && i + 1 < argc) replayFile = argv[++i];
+        else if(!strcmp(argv[i], "--headless")) headless = true;
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--record file.aimrec | --no-record] [--replay file.aimrec [--headless]]" << std::endl;
+            return 1;
+        }
+    }
+
+    // A replay brings its own level, tick rate and spawner seed
+    SessionReplay replay;
+    std::string levelFile = LEVEL_FILE;
+    uint32_t tickRate = TICK_RATE;
+    uint32_t seed = std::random_device()();
+    if(replayFile)
+    {
+        if(!replay.open(replayFile)) return 1;
+        levelFile = replay.getHeader().level;
+        tickRate = replay.getHeader().tickRate;
+        seed = replay.getHeader().seed;
+        recordFile = nullptr;
+    }
+    else headless = false;
+
     GLFWwindow* window;
     try{
-        window = initWindow(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_TITLE);
+        // Headless replays still need a context to load the level into
+        window = initWindow(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_TITLE, !headless);
     }
     catch ( std::exception e )
     {
@@ -115,110 +245,188 @@ int32_t main()
     glm::mat4 projection;
     projection = glm::perspective(glm::radians(45.0f), (float)SCREEN_WIDTH / SCREEN_HEIGHT, 0.1f, 100.0f);
 
-    // Input handlers
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Capture cursor input & hide it
-    glfwSetCursorPosCallback(window, mouse_movement_callback);
+    // Input handlers, a replay takes its input from the log
+    if(!replayFile) MouseInput::Init(window);
     glfwSetScrollCallback(window, scroll_callback);
 
-    // Wall definitions
-    float rectWidth = 1.0f, rectHeight = 1.0f;
-    std::vector<std::vector<glm::vec3>> wallDefinitions = {
-
-        // Left side walls
-        { glm::vec3(-1.0f, 0.5f,  1.5f), glm::vec3(-1.0f, 0.0f, 0.0f)},
-        { glm::vec3(-1.0f, 0.5f,  0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)},
-        { glm::vec3(-1.0f, 0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)},
-        { glm::vec3(-1.0f, 0.5f, -1.5f), glm::vec3(-1.0f, 0.0f, 0.0f)},
-
-        // Right Side Walls
-        { glm::vec3(1.0f, 0.5f,  1.5f), glm::vec3(1.0f, 0.0f, 0.0f)},
-        { glm::vec3(1.0f, 0.5f,  0.5f), glm::vec3(1.0f, 0.0f, 0.0f)},
-        { glm::vec3(1.0f, 0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)},
-        { glm::vec3(1.0f, 0.5f, -1.5f), glm::vec3(1.0f, 0.0f, 0.0f)},
-
-        // Bottom Walls
-        { glm::vec3(-0.5f, 0.0f,  1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 0.0f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 0.0f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 0.0f, -1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-
-        { glm::vec3(0.5f, 0.0f,  1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 0.0f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 0.0f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 0.0f, -1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-
-        // Top Walls
-        { glm::vec3(-0.5f, 1.0f,  1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 1.0f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 1.0f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(-0.5f, 1.0f, -1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-
-        { glm::vec3(0.5f, 1.0f,  1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 1.0f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 1.0f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-        { glm::vec3(0.5f, 1.0f, -1.5f), glm::vec3(0.0f, 1.0f, 0.0f)},
-
-    };
-
-    std::vector<std::unique_ptr<WallModel>> walls;
-    for( auto wallDef: wallDefinitions)
+    // Camera matrices are shared by every program through one uniform buffer
+    CameraUniforms::Init();
+    Latency::Init();
+
+    // Build the room
+    Scene scene;
+    scene.load(levelFile);
+
+    // Start at the level's spawn point
+    glm::vec3 spawnPosition;
+    float spawnYaw, spawnPitch;
+    if(scene.getSpawn(0, spawnPosition, spawnYaw, spawnPitch))
     {
-        walls.push_back(std::make_unique<WallModel>(
-            "shaders/basic", "assets/brick-wall.jpg",
-            true, true,
-            rectWidth, rectHeight,
-            wallDef[0], wallDef[1]
-        ));
+        camera->Position = spawnPosition;
+        camera->SetOrientation(spawnYaw, spawnPitch);
     }
 
-    // push the grey walls
-    std::vector<std::vector<glm::vec3>> greyWallDefinitions = {
-        {glm::vec3( 0.5f, 0.5f, -2.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
-        {glm::vec3(-0.5f, 0.5f, -2.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
-        {glm::vec3( 0.5f, 0.5f,  2.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
-        {glm::vec3(-0.5f, 0.5f,  2.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
-    };
-    for ( auto greyWallDef : greyWallDefinitions)
+    // Targets spawn inside the room and are drawn instanced
+    TargetPool targets;
+    targets.init();
+    targets.setArena(scene.getBounds());
+    targets.seed(seed);
+
+    SessionRecorder recorder;
+    if(recordFile) recorder.open(recordFile, levelFile, tickRate, seed);
+
+    // Re-simulate the whole log as fast as possible and check it ends where the recording did
+    if(headless)
     {
-        walls.push_back(std::make_unique<WallModel>(
-            "shaders/basic", "assets/gray-wall.jpg",
-            true, true,
-            rectWidth, rectHeight,
-            greyWallDef[0], greyWallDef[1]
-        ));
+        FixedTimestep timestep(tickRate);
+        TickInput input;
+        double start = glfwGetTime();
+        while(replay.next(input)) simulateTick(input, scene, targets, timestep.dt());
+        double elapsed = glfwGetTime() - start;
+
+        SessionResult result = captureResult(targets);
+        std::cout << "[DEBUG] Replayed " << replay.ticksPlayed() << " ticks in " << elapsed << " s, score " << targets.hits << "/" << targets.hits + targets.misses << std::endl;
+        bool matches = true;
+        if(replay.hasExpectedResult())
+        {
+            matches = std::memcmp(&result, &replay.getExpectedResult(), sizeof(result)) == 0;
+            std::cout << (matches ? "[DEBUG] Replay matches the recording" : "ERROR::REPLAY: Final state differs from the recording") << std::endl;
+        }
+
+        targets.clear();
+        scene.clear();
+        Latency::Clear();
+        CameraUniforms::Clear();
+        ResourceManager::Clear();
+        glfwTerminate();
+        return matches ? 0 : 1;
     }
+
+    // Shaders and textures edited on disk are rebuilt while running
+    HotReload::Init();
+
+    // Draws of a frame are collected here and issued sorted by state
+    RenderQueue renderQueue;
+    
+    // The simulation runs at a fixed rate, rendering shows a blend of its last two states
+    FixedTimestep timestep(tickRate);
+    PlayerState previousState = PlayerState::Capture(*camera);
+    PlayerState currentState = previousState;
+    Camera renderCamera = *camera;
     
     // Enabling depth test
     glEnable(GL_DEPTH_TEST);
     // Main Rendering loop
     while(!glfwWindowShouldClose(window))
     {
-        // Update the time
-        currFrameTime = glfwGetTime();
-        deltaTime = currFrameTime - lastFrameTime;
-        lastFrameTime = currFrameTime;
+        Profiler::BeginFrame();
 
-        processInput(window);
+        {
+            PROFILE_SCOPE("frame pacing");
+            Latency::BeginFrame();
+            // Per-frame buffers about to be rewritten must be done being read
+            StreamBuffer::BeginFrame();
+        }
 
-        // Screen Background color
-        glClearColor(0.5f, 0.6f, 0.6f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        {
+            PROFILE_SCOPE("input");
+            processInput(window);
+        }
 
-        // Update the camera 
-        view = camera->GetViewMatrix();
-        projection = glm::perspective(glm::radians(camera->Zoom), (float)SCREEN_WIDTH / SCREEN_HEIGHT, 0.1f, 100.0f);
+        {
+            PROFILE_SCOPE("simulation");
+
+            unsigned int ticks = timestep.advance(glfwGetTime());
+            for(unsigned int i = 0; i < ticks; i++)
+            {
+                TickInput input;
+                if(replayFile)
+                {
+                    // The log ran out, the session is over
+                    if(!replay.next(input))
+                    {
+                        glfwSetWindowShouldClose(window, true);
+                        break;
+                    }
+                }
+                else input = sampleInput(window, timestep.tickEndTime(i, ticks));
+                recorder.record(input);
+
+                previousState = currentState;
+                simulateTick(input, scene, targets, timestep.dt());
+                currentState = PlayerState::Capture(*camera);
+            }
+            Latency::MarkSimulated();
+        }
+
+        {
+            PROFILE_SCOPE("update");
+
+            // Rebuild edited resources, then swap in any textures that finished decoding
+            HotReload::Update();
+            TextureLoader::Update();
+
+            // Place the view between the last two ticks. Orientation is taken from the
+            // newest tick, interpolating it would hold aim back by up to a tick
+            PlayerState rendered = PlayerState::Interpolate(previousState, currentState, timestep.alpha());
+            renderCamera = *camera;
+            renderCamera.Position = rendered.position;
+
+            // Late input sampling: poll once more right before building the view and show motion
+            // the simulation has not reached yet. The ticks still consume it, so nothing is applied twice
+            if(Latency::LowLatency && !replayFile)
+            {
+                PROFILE_SCOPE("late input");
+                glfwPollEvents();
+                MouseMotion pending = MouseInput::Pending();
+                if(pending.count > 0)
+                {
+                    renderCamera.ProcessMouseMovement(pending.dx, pending.dy, true);
+                    Latency::MarkInput(pending.oldest, pending.newest);
+                }
+            }
+
+            // Update the camera 
+            view = renderCamera.GetViewMatrix();
+            projection = glm::perspective(glm::radians(renderCamera.Zoom), (float)SCREEN_WIDTH / SCREEN_HEIGHT, 0.1f, 100.0f);
+            CameraUniforms::Update(projection, view);
+        }
+
+        {
+            PROFILE_SCOPE("draw submission");
+            PROFILE_GPU_SCOPE("scene");
+
+            // Screen Background color
+            glClearColor(0.5f, 0.6f, 0.6f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Draw the walls and targets
+            scene.submit(renderQueue, Frustum(projection * view));
+            targets.submit(renderQueue, timestep.alpha());
+            renderQueue.flush();
+            StreamBuffer::EndFrame();
+            Latency::MarkSubmitted();
+        }
 
-        // Draw the walls
-        for(auto& wall: walls)
         {
-            wall->draw(projection, view);
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+            Latency::MarkSwapped();
+            glfwPollEvents();
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        Profiler::EndFrame();
     }
     
     // Clean up
+    recorder.close(captureResult(targets));
+    HotReload::Clear();
+    StreamBuffer::Clear();
+    Latency::Clear();
+    Profiler::Clear();
+    targets.clear();
+    scene.clear();
+    CameraUniforms::Clear();
     ResourceManager::Clear();
     glfwTerminate();
     return 0;
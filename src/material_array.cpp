@@ -0,0 +1,286 @@
+#include "material_array.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+#include "shader.hpp"
+#include "gl_ext.hpp"
+#include "render_queue.hpp"
+
+// std140 layout of one entry of the Materials block
+struct MaterialBlockEntry
+{
+    float rect[4];
+    float layer[4];
+};
+
+MaterialArray::MaterialArray()
+{
+    this->texture = 0;
+    this->UBO = 0;
+    this->layerWidth = this->layerHeight = 0;
+    this->layers = this->levels = 0;
+    this->format = COOKED_RGB8;
+    this->alpha = false;
+    this->built = false;
+}
+
+uint32_t MaterialArray::add(const std::string& file, bool alpha)
+{
+    if(this->built) throw std::runtime_error("Cannot add materials to a MaterialArray after it is built");
+    if(this->sources.size() >= MAX_MATERIALS) throw std::runtime_error("Too many materials, at most " + std::to_string(MAX_MATERIALS) + " fit in one array");
+
+    this->sources.push_back({ file, alpha });
+    return this->sources.size() - 1;
+}
+
+// Levels a region at this offset can keep: level n puts it at offset >> n, which has to stay a whole number of blocks
+static unsigned int alignedLevels(unsigned int offset, unsigned int block)
+{
+    if(offset == 0) return ~0u;
+    unsigned int levels = 1;
+    while(offset % (block << levels) == 0) levels++;
+    return levels;
+}
+
+static unsigned int alignUp(unsigned int value, unsigned int alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+unsigned int MaterialArray::pack(const std::vector<CookedTexture>& cooked)
+{
+    this->layerWidth = this->layerHeight = 0;
+    for(const CookedTexture& texture: cooked)
+    {
+        this->layerWidth = std::max(this->layerWidth, texture.levels[0].Width);
+        this->layerHeight = std::max(this->layerHeight, texture.levels[0].Height);
+    }
+
+    // Tallest first keeps the shelves tight
+    std::vector<uint32_t> order(cooked.size());
+    for(uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&cooked](uint32_t a, uint32_t b) {
+        const TextureLevel &levelA = cooked[a].levels[0], &levelB = cooked[b].levels[0];
+        if(levelA.Height != levelB.Height) return levelA.Height > levelB.Height;
+        return levelA.Width > levelB.Width;
+    });
+
+    this->regions.resize(cooked.size());
+    unsigned int layer = 0, cursorX = 0, shelfY = 0, shelfHeight = 0;
+    for(uint32_t i: order)
+    {
+        unsigned int width = cooked[i].levels[0].Width, height = cooked[i].levels[0].Height;
+
+        // Next to the last region, else on a new shelf, else on a new layer
+        unsigned int x = alignUp(cursorX, ATLAS_ALIGNMENT);
+        if(x + width > this->layerWidth)
+        {
+            x = 0;
+            shelfY = alignUp(shelfY + shelfHeight, ATLAS_ALIGNMENT);
+            shelfHeight = 0;
+        }
+        if(shelfY + height > this->layerHeight)
+        {
+            layer++;
+            x = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+        }
+
+        this->regions[i] = { layer, x, shelfY, width, height };
+        cursorX = x + width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+    return layer + 1;
+}
+
+void MaterialArray::build()
+{
+    if(this->sources.empty()) return;
+
+    // One array has one format, a single material with alpha promotes them all
+    bool alpha = false;
+    for(const Source& source: this->sources) alpha = alpha || source.alpha;
+    this->alpha = alpha;
+
+    std::vector<CookedTexture> cooked(this->sources.size());
+    for(size_t i = 0; i < this->sources.size(); i++)
+    {
+        if(!TextureCache::Load(this->sources[i].file, alpha, GLExt::TextureCompressionS3TC, cooked[i]))
+        {
+            for(CookedTexture& texture: cooked) TextureCache::Release(texture);
+            throw std::runtime_error("Failed to load material texture " + this->sources[i].file);
+        }
+        if(cooked[i].format != cooked[0].format)
+        {
+            for(CookedTexture& texture: cooked) TextureCache::Release(texture);
+            throw std::runtime_error("Material texture " + this->sources[i].file + " was cooked to a different format than the rest of the array");
+        }
+    }
+
+    // Everything loaded, only now is the previous packing replaced
+    this->format = cooked[0].format;
+    this->layers = this->pack(cooked);
+    this->upload(cooked);
+    for(CookedTexture& texture: cooked) TextureCache::Release(texture);
+
+    this->uploadRegions();
+    this->built = true;
+
+    std::cout << "[DEBUG] Built material array: " << this->sources.size() << " materials in " << this->layers << " layers of "
+              << this->layerWidth << "x" << this->layerHeight << ", " << this->levels << " levels" << std::endl;
+}
+
+void MaterialArray::upload(const std::vector<CookedTexture>& cooked)
+{
+    const CookedFormat format = cooked[0].format;
+    const bool compressed = format == COOKED_BC1;
+    const unsigned int internalFormat = TextureCache::InternalFormat(format);
+    const unsigned int imageFormat = format == COOKED_RGBA8 ? GL_RGBA : GL_RGB;
+    // Compressed regions can only start on a block boundary
+    const unsigned int block = compressed ? 4 : 1;
+
+    // The chain ends where the shortest source chain or a region's alignment runs out
+    this->levels = 1;
+    while(std::max(this->layerWidth, this->layerHeight) >> this->levels) this->levels++;
+    for(size_t i = 0; i < cooked.size(); i++)
+    {
+        const MaterialRegion& region = this->regions[i];
+        this->levels = std::min(this->levels, (unsigned int)cooked[i].levels.size());
+        this->levels = std::min(this->levels, alignedLevels(region.x, block));
+        this->levels = std::min(this->levels, alignedLevels(region.y, block));
+        // Odd layer sizes round down faster than a region's offset plus size, drop levels it would hang off
+        while(this->levels > 1 && (region.x >> (this->levels - 1)) + std::max(1u, region.width >> (this->levels - 1)) > std::max(1u, this->layerWidth >> (this->levels - 1)))
+            this->levels--;
+        while(this->levels > 1 && (region.y >> (this->levels - 1)) + std::max(1u, region.height >> (this->levels - 1)) > std::max(1u, this->layerHeight >> (this->levels - 1)))
+            this->levels--;
+    }
+
+    // A rebuild respecifies the existing texture, whatever holds its name keeps drawing with it
+    if(this->texture == 0) glGenTextures(1, &this->texture);
+    RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, this->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for(unsigned int level = 0; level < this->levels; level++)
+    {
+        unsigned int width = std::max(1u, this->layerWidth >> level), height = std::max(1u, this->layerHeight >> level);
+
+        // Allocate every layer of the level, the regions are copied in below
+        if(compressed)
+        {
+            size_t layerSize = (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, this->layers, 0, layerSize * this->layers, nullptr);
+        }
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, this->layers, 0, imageFormat, GL_UNSIGNED_BYTE, nullptr);
+
+        for(size_t i = 0; i < cooked.size(); i++) this->uploadRegion(level, this->regions[i], cooked[i].levels[level]);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Regions are clamped in the shader, nothing may wrap into a neighbour
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, this->levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, 0);
+}
+
+void MaterialArray::uploadRegion(unsigned int level, const MaterialRegion& region, const TextureLevel& mip)
+{
+    const unsigned int internalFormat = TextureCache::InternalFormat(this->format);
+    const unsigned int imageFormat = this->format == COOKED_RGBA8 ? GL_RGBA : GL_RGB;
+    unsigned int width = std::max(1u, this->layerWidth >> level), height = std::max(1u, this->layerHeight >> level);
+    unsigned int x = region.x >> level, y = region.y >> level;
+    if(this->format == COOKED_BC1)
+    {
+        // Whole blocks are copied, clipped only where the region meets the edge of the layer
+        unsigned int copyWidth = std::min(alignUp(mip.Width, 4), width - x);
+        unsigned int copyHeight = std::min(alignUp(mip.Height, 4), height - y);
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, region.layer, copyWidth, copyHeight, 1, internalFormat, mip.Size, mip.Data);
+    }
+    else
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, region.layer, mip.Width, mip.Height, 1, imageFormat, GL_UNSIGNED_BYTE, mip.Data);
+}
+
+bool MaterialArray::reload(uint32_t material)
+{
+    if(!this->built || material >= this->sources.size()) return false;
+
+    const std::string& file = this->sources[material].file;
+    CookedTexture cooked;
+    if(!TextureCache::Load(file, this->alpha, GLExt::TextureCompressionS3TC, cooked))
+    {
+        std::cout << "ERROR::MATERIAL_ARRAY: Failed to reload " << file << ", keeping the previous texture" << std::endl;
+        return false;
+    }
+
+    // Same size, format and enough levels, only its own region changes
+    const MaterialRegion& region = this->regions[material];
+    if(cooked.format == this->format && cooked.levels[0].Width == region.width && cooked.levels[0].Height == region.height
+        && cooked.levels.size() >= this->levels)
+    {
+        RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, this->texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(unsigned int level = 0; level < this->levels; level++) this->uploadRegion(level, region, cooked.levels[level]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, 0);
+        TextureCache::Release(cooked);
+
+        std::cout << "[DEBUG] Reloaded material " << material << " in place: " << file << std::endl;
+        return true;
+    }
+    TextureCache::Release(cooked);
+
+    // The packing no longer holds, build() only replaces it once every texture loaded
+    try
+    {
+        this->build();
+    }
+    catch(std::exception& e)
+    {
+        std::cout << "ERROR::MATERIAL_ARRAY: Failed to rebuild after " << file << " changed, keeping the previous array: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void MaterialArray::uploadRegions()
+{
+    std::vector<MaterialBlockEntry> entries(MAX_MATERIALS);
+    for(size_t i = 0; i < this->regions.size(); i++)
+    {
+        const MaterialRegion& region = this->regions[i];
+        MaterialBlockEntry& entry = entries[i];
+        entry.rect[0] = (float)region.x / this->layerWidth;
+        entry.rect[1] = (float)region.y / this->layerHeight;
+        entry.rect[2] = (float)region.width / this->layerWidth;
+        entry.rect[3] = (float)region.height / this->layerHeight;
+        entry.layer[0] = (float)region.layer;
+        // The shader sizes its edge clamp by the level it samples
+        entry.layer[1] = (float)(this->levels - 1);
+    }
+
+    if(this->UBO == 0) glGenBuffers(1, &this->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, entries.size() * sizeof(MaterialBlockEntry), entries.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, this->UBO);
+}
+
+void MaterialArray::clear()
+{
+    if(this->texture != 0) glDeleteTextures(1, &this->texture);
+    if(this->UBO != 0) glDeleteBuffers(1, &this->UBO);
+    this->texture = 0;
+    this->UBO = 0;
+    this->sources.clear();
+    this->regions.clear();
+    this->layers = this->levels = 0;
+    this->built = false;
+}
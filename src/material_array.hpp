@@ -0,0 +1,87 @@
+#ifndef __MATERIAL_ARRAY_HPP__
+#define __MATERIAL_ARRAY_HPP__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include <glad/glad.h>
+
+#include "texture_cache.hpp"
+
+// Materials one array can hold, the Materials block in shaders/basic.fs is sized to match
+const unsigned int MAX_MATERIALS = 64;
+// Atlas regions start on multiples of this many texels. Mip level n of the array places them at
+// offset >> n, so the alignment bounds how many levels an atlas with packed regions can keep
+const unsigned int ATLAS_ALIGNMENT = 128;
+
+// Where a material's texture sits inside the array, in level 0 texels
+struct MaterialRegion
+{
+    unsigned int layer;
+    unsigned int x, y;
+    unsigned int width, height;
+};
+
+/**
+ * Packs the textures of many materials into a single GL_TEXTURE_2D_ARRAY
+ * so everything using them can be drawn without switching textures.
+ *
+ * Every layer is as large as the largest texture. A texture of that size
+ * takes a whole layer, smaller ones are shelf packed as atlas regions,
+ * several to a layer. The shader finds a material's layer and region
+ * through the Materials uniform block:
+ *   regions[i].rect   xy offset, zw scale from the material's UVs to the layer's
+ *   regions[i].layer  x is the layer index, y the last mip level
+ * Textures are read from the TextureCache, so their cooked mip chains are
+ * copied in level by level and nothing is generated at runtime.
+ *
+ * reload() refreshes one material after its file changed. A texture that
+ * still fits its region is copied over it, anything else repacks the whole
+ * array into the same texture object, so batches holding it stay valid.
+ */
+class MaterialArray
+{
+    private:
+        struct Source
+        {
+            std::string file;
+            bool alpha;
+        };
+
+        std::vector<Source> sources;
+        std::vector<MaterialRegion> regions;
+
+        unsigned int texture, UBO;
+        unsigned int layerWidth, layerHeight, layers, levels;
+        CookedFormat format;
+        bool alpha; // Any source has alpha, the whole array is then stored with it
+        bool built;
+
+        // Places every texture, returns the number of layers used
+        unsigned int pack(const std::vector<CookedTexture>& cooked);
+        void upload(const std::vector<CookedTexture>& cooked);
+        // Copies one level of a material's texture into its region, the array must be bound
+        void uploadRegion(unsigned int level, const MaterialRegion& region, const TextureLevel& mip);
+        void uploadRegions();
+
+    public:
+        MaterialArray();
+
+        // Queues a texture file, returns its material index. Indices count up from 0 in the order added
+        uint32_t add(const std::string& file, bool alpha);
+        // Loads, packs and uploads every texture and binds the Materials block, no materials can be added afterwards
+        void build();
+        // Reloads a material whose file changed, false keeps the previous contents
+        bool reload(uint32_t material);
+        // Deletes the array and its uniform buffer, must be called while the context is alive
+        void clear();
+
+        unsigned int getTexture() const { return texture; }
+        const MaterialRegion& getRegion(uint32_t material) const { return regions[material]; }
+        const std::string& getFile(uint32_t material) const { return sources[material].file; }
+        size_t materialCount() const { return sources.size(); }
+        unsigned int layerCount() const { return layers; }
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "mesh_packer.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+bool MeshPacker::PackVertices = true;
+
+uint16_t MeshPacker::HalfFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t floatExponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // infinity stays infinity, NaN stays a quiet NaN
+    if(floatExponent == 0xFF) return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+
+    int exponent = (int)floatExponent - 127 + 15;
+    if(exponent >= 31) return sign | 0x7C00;
+    if(exponent <= 0)
+    {
+        // below the smallest normal half, shift the implicit bit into a subnormal
+        if(exponent < -10) return sign;
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 1))) half++;
+        return sign | half;
+    }
+
+    // round to nearest even, a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+    return sign | half;
+}
+
+int16_t MeshPacker::Snorm16(float value)
+{
+    return (int16_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+uint16_t MeshPacker::Unorm16(float value)
+{
+    return (uint16_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+
+void MeshPacker::OctEncode(const glm::vec3 &normal, int16_t out[2])
+{
+    // project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    float x = normal.x / length, y = normal.y / length;
+    if(normal.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = Snorm16(x);
+    out[1] = Snorm16(y);
+}
+
+// How one element is stored
+struct Encoding
+{
+    GLenum type;
+    GLboolean normalized;
+    unsigned int components; // stored, octahedral normals shrink 3 to 2
+    unsigned int size;       // bytes including padding to 4
+};
+
+static Encoding chooseEncoding(const float *vertices, size_t vertexCount, size_t floatsPerVertex, size_t first, const VertexElement &element)
+{
+    if(!MeshPacker::PackVertices)
+        return { GL_FLOAT, GL_FALSE, element.components, element.components * (unsigned int)sizeof(float) };
+
+    // Scan the element's values, the normalized encodings only hold a limited range
+    float minimum = 0.0f, maximum = 0.0f;
+    bool whole = true;
+    for(size_t v = 0; v < vertexCount; v++)
+    {
+        for(unsigned int c = 0; c < element.components; c++)
+        {
+            float value = vertices[v * floatsPerVertex + first + c];
+            if(v == 0 && c == 0) minimum = maximum = value;
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+            whole = whole && value == std::floor(value);
+        }
+    }
+
+    unsigned int components = element.components;
+    GLenum type = GL_HALF_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    switch(element.kind)
+    {
+        case ATTRIB_POSITION:
+            if(minimum >= -1.0f && maximum <= 1.0f) { type = GL_SHORT; normalized = GL_TRUE; }
+            else std::cout << "[DEBUG] Mesh positions span " << minimum << ".." << maximum << ", packed as half floats" << std::endl;
+            break;
+        case ATTRIB_TEXCOORD:
+            if(minimum >= 0.0f && maximum <= 1.0f) { type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; }
+            break;
+        case ATTRIB_NORMAL:
+            if(element.components != 3) throw std::runtime_error("Normals must have 3 components to be packed");
+            type = GL_SHORT;
+            normalized = GL_TRUE;
+            components = 2;
+            break;
+        case ATTRIB_INDEX:
+            if(!whole || minimum < 0.0f || maximum > 65535.0f)
+                return { GL_FLOAT, GL_FALSE, element.components, element.components * (unsigned int)sizeof(float) };
+            type = GL_UNSIGNED_SHORT;
+            break;
+    }
+    return { type, normalized, components, (components * 2 + 3) / 4 * 4 };
+}
+
+PackedMesh MeshPacker::Pack(const float *vertices, size_t vertexCount, const VertexElement *layout, size_t elementCount,
+                            const unsigned int *indices, size_t indexCount)
+{
+    size_t floatsPerVertex = 0;
+    for(size_t e = 0; e < elementCount; e++) floatsPerVertex += layout[e].components;
+
+    PackedMesh mesh;
+    std::vector<Encoding> encodings;
+    mesh.stride = 0;
+    size_t first = 0;
+    for(size_t e = 0; e < elementCount; e++)
+    {
+        Encoding encoding = chooseEncoding(vertices, vertexCount, floatsPerVertex, first, layout[e]);
+        encodings.push_back(encoding);
+        mesh.attributes.push_back({ layout[e].location, encoding.components, encoding.type, encoding.normalized, mesh.stride });
+        mesh.stride += encoding.size;
+        first += layout[e].components;
+    }
+
+    mesh.vertexCount = vertexCount;
+    mesh.vertices.assign((size_t)mesh.stride * vertexCount, 0);
+    for(size_t v = 0; v < vertexCount; v++)
+    {
+        const float *source = vertices + v * floatsPerVertex;
+        unsigned char *vertex = mesh.vertices.data() + v * mesh.stride;
+        for(size_t e = 0; e < elementCount; e++)
+        {
+            const Encoding &encoding = encodings[e];
+            unsigned char *out = vertex + mesh.attributes[e].offset;
+
+            if(layout[e].kind == ATTRIB_NORMAL && encoding.type == GL_SHORT)
+            {
+                int16_t octahedral[2];
+                OctEncode(glm::vec3(source[0], source[1], source[2]), octahedral);
+                memcpy(out, octahedral, sizeof(octahedral));
+            }
+            else
+            {
+                for(unsigned int c = 0; c < layout[e].components; c++)
+                {
+                    switch(encoding.type)
+                    {
+                        case GL_FLOAT:          memcpy(out + c * sizeof(float), &source[c], sizeof(float)); break;
+                        case GL_HALF_FLOAT:     { uint16_t value = HalfFloat(source[c]); memcpy(out + c * 2, &value, 2); break; }
+                        case GL_SHORT:          { int16_t value = Snorm16(source[c]); memcpy(out + c * 2, &value, 2); break; }
+                        case GL_UNSIGNED_SHORT: { uint16_t value = encoding.normalized ? Unorm16(source[c]) : (uint16_t)source[c]; memcpy(out + c * 2, &value, 2); break; }
+                    }
+                }
+            }
+            source += layout[e].components;
+        }
+    }
+
+    // Indices can only be narrowed if every vertex stays addressable
+    mesh.indexCount = indexCount;
+    mesh.indexType = PackVertices && vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh.indices.resize((size_t)indexCount * mesh.indexSize());
+    if(mesh.indexType == GL_UNSIGNED_SHORT)
+    {
+        uint16_t *out = (uint16_t *)mesh.indices.data();
+        for(size_t i = 0; i < indexCount; i++) out[i] = (uint16_t)indices[i];
+    }
+    else if(indexCount > 0)
+        memcpy(mesh.indices.data(), indices, indexCount * sizeof(uint32_t));
+
+    return mesh;
+}
+
+void MeshPacker::Upload(const PackedMesh &mesh, unsigned int VBO, unsigned int EBO)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
+
+    if(EBO != 0)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size(), mesh.indices.data(), GL_STATIC_DRAW);
+    }
+
+    // The shaders declare float inputs, glVertexAttribPointer converts (and normalizes) on fetch
+    for(const PackedAttribute &attribute: mesh.attributes)
+    {
+        glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, mesh.stride, (void *) (uintptr_t) attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
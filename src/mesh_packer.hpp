@@ -0,0 +1,93 @@
+#ifndef __MESH_PACKER_HPP__
+#define __MESH_PACKER_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// What an attribute of the float vertices a mesh is built from holds, which decides how it is packed
+enum AttributeKind
+{
+    ATTRIB_POSITION, // snorm16 when every coordinate is within [-1, 1], half float otherwise
+    ATTRIB_TEXCOORD, // unorm16 when within [0, 1], half float otherwise
+    ATTRIB_NORMAL,   // unit vector, octahedral encoded into two snorm16
+    ATTRIB_INDEX,    // small whole numbers like material ids, unsigned short read as a float
+};
+
+// One attribute of the source vertices, elements follow each other without gaps
+struct VertexElement
+{
+    unsigned int location;
+    unsigned int components;
+    AttributeKind kind;
+};
+
+// Position (3) + Texture coords (2), the layout of ObjectModel::vertices
+const VertexElement MODEL_VERTEX_LAYOUT[] = {
+    { 0, 3, ATTRIB_POSITION },
+    { 1, 2, ATTRIB_TEXCOORD },
+};
+const size_t MODEL_VERTEX_ELEMENTS = sizeof(MODEL_VERTEX_LAYOUT) / sizeof(VertexElement);
+
+// Where and how an attribute ended up in the packed vertex
+struct PackedAttribute
+{
+    unsigned int location;
+    unsigned int components;
+    GLenum type;
+    GLboolean normalized;
+    unsigned int offset; // bytes from the start of the vertex
+};
+
+// Vertices and indices ready for upload
+struct PackedMesh
+{
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned char> indices;
+    std::vector<PackedAttribute> attributes;
+    unsigned int stride;
+    unsigned int vertexCount, indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT whenever the vertex count allows it
+
+    unsigned int indexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+};
+
+/**
+ * Turns the float vertices and 32 bit indices meshes are generated with
+ * into the compact form uploaded to the GPU. Every attribute is stored in
+ * 16 bit components, each starting on a 4 byte boundary:
+ *   position  8 bytes (3 components + padding)
+ *   texcoord  4 bytes
+ *   normal    4 bytes, decoded in the shader with
+ *               vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+ *               if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+ *               n = normalize(n);
+ *   index     4 bytes (1 component + padding)
+ * Positions and texture coordinates fall back to half floats when they
+ * leave the normalized range, so shaders read every attribute as the same
+ * float they were generated as, within 16 bit precision.
+ * Meshes with at most 65536 vertices get 16 bit indices.
+ */
+class MeshPacker
+{
+public:
+    // false keeps 32 bit floats and indices, for comparing against the packed output
+    static bool PackVertices;
+
+    static PackedMesh Pack(const float *vertices, size_t vertexCount, const VertexElement *layout, size_t elementCount,
+                           const unsigned int *indices, size_t indexCount);
+    // fills the buffers and points the attributes of the bound vertex array at them, EBO may be 0 for unindexed meshes
+    static void Upload(const PackedMesh &mesh, unsigned int VBO, unsigned int EBO);
+
+    // component encoders, rounding to nearest
+    static uint16_t HalfFloat(float value);
+    static int16_t  Snorm16(float value);
+    static uint16_t Unorm16(float value);
+    static void     OctEncode(const glm::vec3 &normal, int16_t out[2]);
+private:
+    MeshPacker() { }
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "mouse_input.hpp"
+
+#include <iostream>
+
+bool MouseInput::RawMotion = false;
+SpscRing<MouseDelta, MOUSE_RING_SIZE> MouseInput::events;
+float MouseInput::overflowX = 0.0f;
+float MouseInput::overflowY = 0.0f;
+double MouseInput::lastX = 0.0;
+double MouseInput::lastY = 0.0;
+bool MouseInput::firstEvent = true;
+
+void MouseInput::Init(GLFWwindow* window)
+{
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Capture cursor input & hide it
+
+    // Raw motion skips the OS pointer acceleration, only available with a disabled cursor
+    RawMotion = glfwRawMouseMotionSupported() == GLFW_TRUE;
+    if(RawMotion) glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+    std::cout << "[DEBUG] Raw mouse motion " << (RawMotion ? "enabled" : "not supported") << std::endl;
+
+    firstEvent = true;
+    glfwSetCursorPosCallback(window, cursorCallback);
+}
+
+void MouseInput::cursorCallback(GLFWwindow* window, double xpos, double ypos)
+{
+    // The first position only sets the reference, there is no motion yet
+    if(firstEvent)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstEvent = false;
+        return;
+    }
+
+    MouseDelta delta;
+    delta.time = glfwGetTime();
+    delta.dx = (float) (xpos - lastX) + overflowX;
+    delta.dy = (float) (lastY - ypos) + overflowY; // Window y grows downwards
+    lastX = xpos;
+    lastY = ypos;
+
+    if(events.push(delta)) overflowX = overflowY = 0.0f;
+    else
+    {
+        overflowX = delta.dx;
+        overflowY = delta.dy;
+    }
+}
+
+static void accumulate(MouseMotion& motion, const MouseDelta& delta)
+{
+    if(motion.count == 0) motion.oldest = delta.time;
+    motion.newest = delta.time;
+    motion.dx += delta.dx;
+    motion.dy += delta.dy;
+    motion.count++;
+}
+
+MouseMotion MouseInput::Consume(double time)
+{
+    MouseMotion motion = { 0.0f, 0.0f, 0, 0.0, 0.0 };
+    for(const MouseDelta *delta = events.peek(); delta && delta->time <= time; delta = events.peek())
+    {
+        accumulate(motion, *delta);
+        events.pop();
+    }
+    return motion;
+}
+
+MouseMotion MouseInput::Pending()
+{
+    MouseMotion motion = { 0.0f, 0.0f, 0, 0.0, 0.0 };
+    for(const MouseDelta *delta = events.peek(); delta; delta = events.peek(motion.count))
+        accumulate(motion, *delta);
+    return motion;
+}
@@ -0,0 +1,62 @@
+#ifndef __MOUSE_INPUT_HPP__
+#define __MOUSE_INPUT_HPP__
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "spsc_ring.hpp"
+
+// Mouse deltas buffered between simulation ticks, 1024 events is over 100 ms at 8 kHz polling
+const size_t MOUSE_RING_SIZE = 1024;
+
+// One cursor event, stamped with glfwGetTime() when GLFW delivered it. GLFW reports no
+// hardware time, so this is the time of the glfwPollEvents() call that dispatched it
+struct MouseDelta
+{
+    double time;
+    float dx, dy; // dy is positive upwards
+};
+
+// A run of deltas summed together
+struct MouseMotion
+{
+    float dx, dy;
+    unsigned int count;    // events summed, 0 if there was no motion
+    double oldest, newest; // time stamps of the first and last event summed
+};
+
+// A static mouse input path for aiming. The cursor is captured and, where
+// the platform supports it, switched to raw (unaccelerated) motion. Each
+// event is timestamped into a lock free ring instead of turning the
+// camera directly, and the simulation drains it once per tick, so the
+// camera trig runs once per tick however high the polling rate is.
+//
+// Timing is only as fine as the polling. Events are dispatched by
+// glfwPollEvents() once per frame (twice with late input sampling), and
+// every event of one poll gets nearly the same stamp, so a frame's motion
+// is not spread over the ticks it physically happened in. It goes to the
+// first tick ending after the poll, usually the last of the frame's ticks.
+class MouseInput
+{
+public:
+    // true once raw motion has been enabled on the window
+    static bool RawMotion;
+
+    // captures the cursor and installs the cursor position callback
+    static void Init(GLFWwindow* window);
+    // removes and sums every delta stamped at or before time
+    static MouseMotion Consume(double time);
+    // sums everything buffered without removing it, for showing motion the simulation has not reached yet
+    static MouseMotion Pending();
+private:
+    MouseInput() { }
+    static void cursorCallback(GLFWwindow* window, double xpos, double ypos);
+
+    static SpscRing<MouseDelta, MOUSE_RING_SIZE> events;
+    // Motion that did not fit in the ring, carried into the next push so none is lost
+    static float overflowX, overflowY;
+    static double lastX, lastY;
+    static bool firstEvent;
+};
+
+#endif
@@ -1,19 +1,103 @@
 #include "object_model.hpp"
 
-ObjectModel::ObjectModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture)
+ObjectModel::ObjectModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, bool batched)
 {
     this->useEBO = useEBO;
     this->shaderName = shaderName;
     this->textureName = textureName;
     this->useTexture = useTexture;
+    this->batched = batched;
+    this->shader = INVALID_HANDLE;
+    this->texture = INVALID_HANDLE;
+    this->VAO = this->VBO = this->EBO = 0;
+    this->indexType = GL_UNSIGNED_INT;
+    this->model = glm::mat4(1.0f);
+    this->transformDirty = true;
 
     if( useTexture && textureName == "" ) throw std::runtime_error("NULL Texture not allowed if you want to use texture");
 
     // Other validations if needed
 }
 
-void ObjectModel::draw(glm::mat4 projection, glm::mat4 view){}
+void ObjectModel::draw(){}
 
 void ObjectModel::init(){}
 
+void ObjectModel::uploadGeometry()
+{
+    PackedMesh mesh = MeshPacker::Pack(this->vertices.data(), this->vertices.size() / FLOATS_PER_VERTEX, MODEL_VERTEX_LAYOUT, MODEL_VERTEX_ELEMENTS,
+                                       this->indices.data(), this->indices.size());
+    this->indexType = mesh.indexType;
+
+    // Generate the Vertex Array Buffer and the Vertex Buffer Objects
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    if(useEBO) glGenBuffers(1, &this->EBO);
+
+    RenderState::BindVertexArray(this->VAO);
+    MeshPacker::Upload(mesh, this->VBO, this->EBO);
+}
+
+void ObjectModel::submit(RenderQueue& queue, const glm::vec3& viewPos) const
+{
+    if( batched ) throw std::runtime_error("Batched objects are submitted by their StaticBatch");
+    if( !useEBO ) throw std::runtime_error("Only indexed objects can be queued");
+
+    DrawItem item;
+    item.shader = this->shader;
+    item.texture = this->useTexture ? this->texture : INVALID_HANDLE;
+    item.VAO = this->VAO;
+    item.indexCount = this->indices.size();
+    item.firstIndex = 0;
+    item.instanceCount = 1;
+    item.indexType = this->indexType;
+    item.modelUniform = this->modelUniform;
+    item.model = &this->getModelMatrix();
+
+    // Distance from the viewer to the object's origin (translation column)
+    glm::vec3 position = glm::vec3((*item.model)[3]);
+    queue.submit(item, glm::length(position - viewPos));
+}
+
+glm::mat4 ObjectModel::computeModelMatrix() const
+{
+    return glm::mat4(1.0f);
+}
+
+const glm::mat4& ObjectModel::getModelMatrix() const
+{
+    if(transformDirty)
+    {
+        model = computeModelMatrix();
+        transformDirty = false;
+    }
+    return model;
+}
+
+AABB ObjectModel::getWorldBounds() const
+{
+    const glm::mat4& model = this->getModelMatrix();
+    AABB bounds;
+    for(size_t i = 0; i + FLOATS_PER_VERTEX <= vertices.size(); i += FLOATS_PER_VERTEX)
+        bounds.extend(glm::vec3(model * glm::vec4(vertices[i], vertices[i + 1], vertices[i + 2], 1.0f)));
+    return bounds;
+}
+
+void ObjectModel::UpdateTransforms(ObjectModel* const* objects, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        ObjectModel* object = objects[i];
+        if(!object->transformDirty) continue;
+
+        object->model = object->computeModelMatrix();
+        object->transformDirty = false;
+    }
+}
+
+void ObjectModel::UpdateTransforms(const std::vector<ObjectModel*>& objects)
+{
+    UpdateTransforms(objects.data(), objects.size());
+}
+
 ObjectModel::~ObjectModel(){}
\ No newline at end of file
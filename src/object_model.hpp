@@ -12,6 +12,12 @@
 #include <iostream>
 
 #include "resource_mgr.hpp"
+#include "render_queue.hpp"
+#include "frustum.hpp"
+#include "mesh_packer.hpp"
+
+// Position (3) + Texture coords (2), matches the basic shader layout
+const size_t FLOATS_PER_VERTEX = 5;
 
 class ObjectModel
 {
@@ -21,20 +27,58 @@ class ObjectModel
         std::string textureName;
         bool useEBO;
         bool useTexture; // Depends on if we are using a texture as defined in the shader
+        bool batched; // Batched objects hand their geometry to a StaticBatch or InstancedMesh and own no GL buffers
+
+        // Resolved from the names when the resources are loaded in init()
+        ShaderHandle shader;
+        TextureHandle texture;
+        Uniform<glm::mat4> modelUniform;
 
         unsigned int VAO, VBO, EBO;
+        GLenum indexType; // Set when the geometry is uploaded, 16 bit for small meshes
 
         std::vector<float> vertices; // Format should be same as the one used in the shader
         std::vector<unsigned int> indices; // if using EBO
 
+        // Cached world transform, only rebuilt when the object moves
+        mutable glm::mat4 model;
+        mutable bool transformDirty;
+
         // Subclasses should implement this
         void generateGeometry();
         void init();
+        // Builds the transform from local geometry to world space, subclasses place themselves here
+        virtual glm::mat4 computeModelMatrix() const;
+        // Packs vertices and indices into a new VAO with its buffers, subclasses call this from init() when not batched
+        void uploadGeometry();
+        // Subclasses call this whenever their placement changes
+        void markTransformDirty() { transformDirty = true; }
 
     public:
-        ObjectModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture);
-        ~ObjectModel();
-        void draw(glm::mat4 projection, glm::mat4 view);
+        ObjectModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, bool batched = false);
+        virtual ~ObjectModel();
+        void draw();
+        // Queues this object for drawing, viewPos orders it front to back within its state
+        void submit(RenderQueue& queue, const glm::vec3& viewPos) const;
+
+        // Returns the cached world transform, recomputing it only if the object moved
+        const glm::mat4& getModelMatrix() const;
+        bool isTransformDirty() const { return transformDirty; }
+        // World space box around the geometry, used to build the scene hierarchy
+        AABB getWorldBounds() const;
+
+        // Recomputes the transforms of many moved objects in one pass, clean objects are skipped
+        static void UpdateTransforms(ObjectModel* const* objects, size_t count);
+        static void UpdateTransforms(const std::vector<ObjectModel*>& objects);
+
+        // Accessors used by the batching code
+        const std::string& getShaderName() const { return shaderName; }
+        const std::string& getTextureName() const { return textureName; }
+        bool usesTexture() const { return useTexture; }
+        ShaderHandle getShader() const { return shader; }
+        TextureHandle getTexture() const { return texture; }
+        const std::vector<float>& getVertices() const { return vertices; }
+        const std::vector<unsigned int>& getIndices() const { return indices; }
 
 
 };
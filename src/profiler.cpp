@@ -0,0 +1,155 @@
+#include "profiler.hpp"
+
+#include <iostream>
+#include <fstream>
+
+bool Profiler::Enabled = true;
+std::vector<Profiler::TraceEvent> Profiler::events;
+size_t Profiler::eventCount = 0;
+std::vector<size_t> Profiler::cpuStack;
+unsigned int Profiler::frame = 0;
+bool Profiler::gpuActive = false;
+bool Profiler::queriesCreated = false;
+Profiler::GpuQuery Profiler::gpuQueries[GPU_QUERY_FRAMES][MAX_GPU_SCOPES];
+unsigned int Profiler::gpuQueryCount[GPU_QUERY_FRAMES] = { 0 };
+
+double Profiler::now()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t Profiler::record(const TraceEvent& event)
+{
+    if(events.size() < MAX_TRACE_EVENTS) events.push_back(event);
+    else events[eventCount % MAX_TRACE_EVENTS] = event;
+    return eventCount++;
+}
+
+void Profiler::BeginFrame()
+{
+    if(!Enabled) return;
+
+    if(!queriesCreated)
+    {
+        for(unsigned int slot = 0; slot < GPU_QUERY_FRAMES; slot++)
+            for(unsigned int i = 0; i < MAX_GPU_SCOPES; i++)
+                glGenQueries(1, &gpuQueries[slot][i].query);
+        queriesCreated = true;
+    }
+
+    BeginCpu("frame");
+}
+
+void Profiler::EndFrame()
+{
+    if(!Enabled) return;
+
+    EndCpu();
+    frame++;
+    // Read the oldest slot before BeginFrame reuses it
+    collectGpu(frame % GPU_QUERY_FRAMES);
+}
+
+void Profiler::BeginCpu(const char *name)
+{
+    if(!Enabled) return;
+
+    TraceEvent event = { name, now(), 0.0, (unsigned int)cpuStack.size(), false };
+    cpuStack.push_back(record(event));
+}
+
+void Profiler::EndCpu()
+{
+    if(!Enabled || cpuStack.empty()) return;
+
+    size_t number = cpuStack.back();
+    cpuStack.pop_back();
+    // A scope open for longer than the ring holds has already been overwritten
+    if(eventCount - number > MAX_TRACE_EVENTS) return;
+    TraceEvent& event = events[number % MAX_TRACE_EVENTS];
+    event.duration = now() - event.start;
+}
+
+void Profiler::BeginGpu(const char *name)
+{
+    if(!Enabled || !queriesCreated || gpuActive) return;
+
+    unsigned int slot = frame % GPU_QUERY_FRAMES;
+    if(gpuQueryCount[slot] >= MAX_GPU_SCOPES) return;
+
+    GpuQuery& query = gpuQueries[slot][gpuQueryCount[slot]++];
+    query.name = name;
+    query.cpuStart = now();
+    glBeginQuery(GL_TIME_ELAPSED, query.query);
+    gpuActive = true;
+}
+
+void Profiler::EndGpu()
+{
+    if(!gpuActive) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuActive = false;
+}
+
+void Profiler::collectGpu(unsigned int slot)
+{
+    for(unsigned int i = 0; i < gpuQueryCount[slot]; i++)
+    {
+        GpuQuery& query = gpuQueries[slot][i];
+
+        // Never wait on the GPU, a result that is not ready yet is dropped
+        int available = 0;
+        glGetQueryObjectiv(query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &elapsed);
+        TraceEvent event = { query.name, query.cpuStart, elapsed / 1000.0, 0, true };
+        record(event);
+    }
+    gpuQueryCount[slot] = 0;
+}
+
+bool Profiler::WriteChromeTrace(const char *file)
+{
+    std::ofstream out(file);
+    if(!out)
+    {
+        std::cout << "ERROR::PROFILER: Failed to open " << file << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events, CPU on thread 1 and GPU on thread 2 so they get separate tracks
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    size_t oldest = eventCount - events.size();
+    for(size_t n = oldest; n < eventCount; n++)
+    {
+        const TraceEvent& event = events[n % MAX_TRACE_EVENTS];
+        if(!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.gpu ? 2 : 1)
+            << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+
+    std::cout << "[DEBUG] Wrote " << events.size() << " profiler events to " << file << std::endl;
+    return true;
+}
+
+void Profiler::Clear()
+{
+    if(queriesCreated)
+    {
+        for(unsigned int slot = 0; slot < GPU_QUERY_FRAMES; slot++)
+            for(unsigned int i = 0; i < MAX_GPU_SCOPES; i++)
+                glDeleteQueries(1, &gpuQueries[slot][i].query);
+        queriesCreated = false;
+    }
+    events.clear();
+    eventCount = 0;
+    cpuStack.clear();
+}
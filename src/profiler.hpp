@@ -0,0 +1,95 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <glad/glad.h>
+
+// Frames a GPU query waits before being read, results are only collected once available so this never stalls
+const unsigned int GPU_QUERY_FRAMES = 3;
+// GPU scopes that can be timed in a single frame
+const unsigned int MAX_GPU_SCOPES = 16;
+// Only the most recent events are kept so a long session cannot grow without bound
+const size_t MAX_TRACE_EVENTS = 1 << 18;
+
+// A static hierarchical frame profiler. CPU sections are timed with
+// ProfileScope, GPU passes with GpuProfileScope (GL_TIME_ELAPSED queries
+// kept in a ring of GPU_QUERY_FRAMES frames). The last MAX_TRACE_EVENTS
+// events can be dumped to a Chrome trace JSON file (chrome://tracing,
+// Perfetto), older ones are overwritten.
+class Profiler
+{
+public:
+    // marks the frame boundaries, EndFrame collects finished GPU queries. Only toggle Enabled between frames
+    static void BeginFrame();
+    static void EndFrame();
+    // CPU sections, nest freely
+    static void BeginCpu(const char *name);
+    static void EndCpu();
+    // GPU passes, GL_TIME_ELAPSED queries cannot nest so neither can these
+    static void BeginGpu(const char *name);
+    static void EndGpu();
+    // writes the retained events, oldest first, as Chrome trace JSON
+    static bool WriteChromeTrace(const char *file);
+    // deletes the GL queries, must be called while the context is alive
+    static void Clear();
+
+    static bool Enabled;
+private:
+    Profiler() { }
+
+    struct TraceEvent
+    {
+        const char *name; // Must be a string literal or otherwise outlive the profiler
+        double start;     // Microseconds since the profiler started
+        double duration;
+        unsigned int depth;
+        bool gpu;
+    };
+
+    struct GpuQuery
+    {
+        unsigned int query;
+        const char *name;
+        double cpuStart; // GPU events are placed on the timeline where they were issued
+    };
+
+    static std::vector<TraceEvent> events; // ring, event n lives at n % MAX_TRACE_EVENTS once full
+    static size_t eventCount; // events ever recorded
+    static std::vector<size_t> cpuStack; // event numbers of the open CPU scopes
+
+    static unsigned int frame;
+    static bool gpuActive;
+    static bool queriesCreated;
+    static GpuQuery gpuQueries[GPU_QUERY_FRAMES][MAX_GPU_SCOPES];
+    static unsigned int gpuQueryCount[GPU_QUERY_FRAMES];
+
+    static double now();
+    // stores the event over the oldest one when full, returns its event number
+    static size_t record(const TraceEvent& event);
+    static void collectGpu(unsigned int slot);
+};
+
+// Times the enclosing block on the CPU
+class ProfileScope
+{
+public:
+    ProfileScope(const char *name) { Profiler::BeginCpu(name); }
+    ~ProfileScope() { Profiler::EndCpu(); }
+};
+
+// Times the GL commands issued in the enclosing block on the GPU
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(const char *name) { Profiler::BeginGpu(name); }
+    ~GpuProfileScope() { Profiler::EndGpu(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+
+#endif
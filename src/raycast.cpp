@@ -0,0 +1,275 @@
+#include "raycast.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RAYCAST_SSE 1
+#endif
+
+// Rays closer to parallel with a panel than this miss it
+static const float PARALLEL_EPSILON = 1e-6f;
+
+void QuadArrays::add(const CollisionQuad& quad)
+{
+    cx.push_back(quad.center.x); cy.push_back(quad.center.y); cz.push_back(quad.center.z);
+    nx.push_back(quad.normal.x); ny.push_back(quad.normal.y); nz.push_back(quad.normal.z);
+    ux.push_back(quad.axisU.x); uy.push_back(quad.axisU.y); uz.push_back(quad.axisU.z);
+    vx.push_back(quad.axisV.x); vy.push_back(quad.axisV.y); vz.push_back(quad.axisV.z);
+    halfU.push_back(quad.halfU);
+    halfV.push_back(quad.halfV);
+}
+
+void QuadArrays::clear()
+{
+    for(std::vector<float>* array: { &cx, &cy, &cz, &nx, &ny, &nz, &ux, &uy, &uz, &vx, &vy, &vz, &halfU, &halfV })
+        array->clear();
+}
+
+#ifdef RAYCAST_SSE
+
+// Lowest lane of distance that is set in mask and closer than best, -1 if none
+static int closestLane(__m128 distance, __m128 mask, float best)
+{
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, distance);
+    int bits = _mm_movemask_ps(mask);
+
+    int closest = -1;
+    for(int i = 0; i < 4; i++)
+    {
+        if((bits & (1 << i)) && lanes[i] < best)
+        {
+            best = lanes[i];
+            closest = i;
+        }
+    }
+    return closest;
+}
+
+static inline __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+// Loads four lanes starting at i, lanes past count are filled with pad
+static inline __m128 load4(const float* values, size_t i, size_t count, float pad)
+{
+    if(i + 4 <= count) return _mm_loadu_ps(values + i);
+    alignas(16) float lanes[4] = { pad, pad, pad, pad };
+    for(size_t j = 0; i + j < count; j++) lanes[j] = values[i + j];
+    return _mm_load_ps(lanes);
+}
+
+void Raycast::IntersectSpheres(const Ray& ray, const SphereArrays& spheres, HitKind kind, RayHit& hit)
+{
+    __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+    __m128 zero = _mm_setzero_ps();
+    float best = std::min(hit.distance, ray.maxDistance);
+
+    for(size_t i = 0; i < spheres.count; i += 4)
+    {
+        // Padding lanes get a negative radius, which never intersects
+        __m128 px = _mm_sub_ps(ox, load4(spheres.x, i, spheres.count, 0.0f));
+        __m128 py = _mm_sub_ps(oy, load4(spheres.y, i, spheres.count, 0.0f));
+        __m128 pz = _mm_sub_ps(oz, load4(spheres.z, i, spheres.count, 0.0f));
+        __m128 radius = load4(spheres.radius, i, spheres.count, -1.0f);
+
+        // |o + t d - c|^2 = r^2 with unit d: t^2 + 2bt + c = 0
+        __m128 b = dot3(px, py, pz, dx, dy, dz);
+        __m128 c = _mm_sub_ps(dot3(px, py, pz, px, py, pz), _mm_mul_ps(radius, radius));
+        __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), c);
+        __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        __m128 nearT = _mm_sub_ps(_mm_sub_ps(zero, b), root);
+        __m128 farT = _mm_add_ps(_mm_sub_ps(zero, b), root);
+
+        // Starting inside a sphere hits it straight away
+        __m128 t = _mm_max_ps(nearT, zero);
+        __m128 mask = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmpge_ps(farT, zero));
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(radius, zero));
+
+        int lane = closestLane(t, mask, best);
+        if(lane < 0) continue;
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, t);
+        best = lanes[lane];
+        hit.distance = best;
+        hit.id = i + lane;
+        hit.kind = kind;
+    }
+}
+
+void Raycast::IntersectQuads(const Ray& ray, const QuadArrays& quads, const uint32_t* ids, size_t count, HitKind kind, RayHit& hit)
+{
+    __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+    __m128 zero = _mm_setzero_ps();
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 epsilon = _mm_set1_ps(PARALLEL_EPSILON);
+    float best = std::min(hit.distance, ray.maxDistance);
+
+    for(size_t i = 0; i < count; i += 4)
+    {
+        // Gather up to four quads into lanes, the leaves of the scene hierarchy hold at most four
+        alignas(16) float lanes[14][4] = { };
+        size_t n = std::min<size_t>(4, count - i);
+        for(size_t j = 0; j < n; j++)
+        {
+            uint32_t id = ids[i + j];
+            lanes[0][j] = quads.cx[id]; lanes[1][j] = quads.cy[id]; lanes[2][j] = quads.cz[id];
+            lanes[3][j] = quads.nx[id]; lanes[4][j] = quads.ny[id]; lanes[5][j] = quads.nz[id];
+            lanes[6][j] = quads.ux[id]; lanes[7][j] = quads.uy[id]; lanes[8][j] = quads.uz[id];
+            lanes[9][j] = quads.vx[id]; lanes[10][j] = quads.vy[id]; lanes[11][j] = quads.vz[id];
+            lanes[12][j] = quads.halfU[id]; lanes[13][j] = quads.halfV[id];
+        }
+        // Empty lanes keep a zero normal and are rejected as parallel
+
+        __m128 nx = _mm_load_ps(lanes[3]), ny = _mm_load_ps(lanes[4]), nz = _mm_load_ps(lanes[5]);
+        __m128 px = _mm_sub_ps(_mm_load_ps(lanes[0]), ox);
+        __m128 py = _mm_sub_ps(_mm_load_ps(lanes[1]), oy);
+        __m128 pz = _mm_sub_ps(_mm_load_ps(lanes[2]), oz);
+
+        // Plane hit distance, then where on the panel it lands relative to the center
+        __m128 denominator = dot3(dx, dy, dz, nx, ny, nz);
+        __m128 parallel = _mm_cmplt_ps(_mm_andnot_ps(signMask, denominator), epsilon);
+        __m128 t = _mm_div_ps(dot3(px, py, pz, nx, ny, nz), denominator); // Parallel lanes are masked out below
+
+        __m128 hx = _mm_sub_ps(_mm_mul_ps(dx, t), px);
+        __m128 hy = _mm_sub_ps(_mm_mul_ps(dy, t), py);
+        __m128 hz = _mm_sub_ps(_mm_mul_ps(dz, t), pz);
+        __m128 u = _mm_andnot_ps(signMask, dot3(hx, hy, hz, _mm_load_ps(lanes[6]), _mm_load_ps(lanes[7]), _mm_load_ps(lanes[8])));
+        __m128 v = _mm_andnot_ps(signMask, dot3(hx, hy, hz, _mm_load_ps(lanes[9]), _mm_load_ps(lanes[10]), _mm_load_ps(lanes[11])));
+
+        __m128 mask = _mm_andnot_ps(parallel, _mm_cmpge_ps(t, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(u, _mm_load_ps(lanes[12])));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(v, _mm_load_ps(lanes[13])));
+
+        int lane = closestLane(t, mask, best);
+        if(lane < 0) continue;
+
+        alignas(16) float distances[4];
+        _mm_store_ps(distances, t);
+        best = distances[lane];
+        hit.distance = best;
+        hit.id = ids[i + lane];
+        hit.kind = kind;
+    }
+}
+
+unsigned int Raycast::IntersectBoxes(const Ray& ray, const glm::vec3& inverseDirection, const AABB* boxes, size_t count, float maxDistance, float* entry)
+{
+    // Empty lanes get an inverted box that is never entered
+    alignas(16) float lanes[6][4] = { { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { -1, -1, -1, -1 }, { -1, -1, -1, -1 }, { -1, -1, -1, -1 } };
+    for(size_t j = 0; j < count && j < 4; j++)
+    {
+        lanes[0][j] = boxes[j].min.x; lanes[1][j] = boxes[j].min.y; lanes[2][j] = boxes[j].min.z;
+        lanes[3][j] = boxes[j].max.x; lanes[4][j] = boxes[j].max.y; lanes[5][j] = boxes[j].max.z;
+    }
+
+    __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    __m128 ix = _mm_set1_ps(inverseDirection.x), iy = _mm_set1_ps(inverseDirection.y), iz = _mm_set1_ps(inverseDirection.z);
+
+    __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[0]), ox), ix), x2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[3]), ox), ix);
+    __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[1]), oy), iy), y2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[4]), oy), iy);
+    __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[2]), oz), iz), z2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lanes[5]), oz), iz);
+
+    __m128 nearT = _mm_max_ps(_mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)), _mm_max_ps(_mm_min_ps(z1, z2), _mm_setzero_ps()));
+    __m128 farT = _mm_min_ps(_mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)), _mm_min_ps(_mm_max_ps(z1, z2), _mm_set1_ps(maxDistance)));
+
+    _mm_storeu_ps(entry, nearT);
+    return _mm_movemask_ps(_mm_cmple_ps(nearT, farT)) & ((1u << std::min<size_t>(count, 4)) - 1);
+}
+
+#else
+
+void Raycast::IntersectSpheres(const Ray& ray, const SphereArrays& spheres, HitKind kind, RayHit& hit)
+{
+    float best = std::min(hit.distance, ray.maxDistance);
+    for(size_t i = 0; i < spheres.count; i++)
+    {
+        glm::vec3 p = ray.origin - glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]);
+        float b = glm::dot(p, ray.direction);
+        float c = glm::dot(p, p) - spheres.radius[i] * spheres.radius[i];
+        float discriminant = b * b - c;
+        if(spheres.radius[i] <= 0.0f || discriminant < 0.0f) continue;
+
+        float root = std::sqrt(discriminant);
+        if(-b + root < 0.0f) continue;
+        float t = std::max(-b - root, 0.0f);
+        if(t >= best) continue;
+
+        best = hit.distance = t;
+        hit.id = i;
+        hit.kind = kind;
+    }
+}
+
+void Raycast::IntersectQuads(const Ray& ray, const QuadArrays& quads, const uint32_t* ids, size_t count, HitKind kind, RayHit& hit)
+{
+    float best = std::min(hit.distance, ray.maxDistance);
+    for(size_t i = 0; i < count; i++)
+    {
+        uint32_t id = ids[i];
+        glm::vec3 center(quads.cx[id], quads.cy[id], quads.cz[id]);
+        glm::vec3 normal(quads.nx[id], quads.ny[id], quads.nz[id]);
+        float denominator = glm::dot(ray.direction, normal);
+        if(std::fabs(denominator) < PARALLEL_EPSILON) continue;
+
+        float t = glm::dot(center - ray.origin, normal) / denominator;
+        if(t < 0.0f || t >= best) continue;
+
+        glm::vec3 p = ray.origin + ray.direction * t - center;
+        if(std::fabs(glm::dot(p, glm::vec3(quads.ux[id], quads.uy[id], quads.uz[id]))) > quads.halfU[id]) continue;
+        if(std::fabs(glm::dot(p, glm::vec3(quads.vx[id], quads.vy[id], quads.vz[id]))) > quads.halfV[id]) continue;
+
+        best = hit.distance = t;
+        hit.id = id;
+        hit.kind = kind;
+    }
+}
+
+unsigned int Raycast::IntersectBoxes(const Ray& ray, const glm::vec3& inverseDirection, const AABB* boxes, size_t count, float maxDistance, float* entry)
+{
+    unsigned int mask = 0;
+    for(size_t j = 0; j < count && j < 4; j++)
+    {
+        glm::vec3 t1 = (boxes[j].min - ray.origin) * inverseDirection;
+        glm::vec3 t2 = (boxes[j].max - ray.origin) * inverseDirection;
+        glm::vec3 lo = glm::min(t1, t2), hi = glm::max(t1, t2);
+        float nearT = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+        float farT = std::min(std::min(hi.x, hi.y), std::min(hi.z, maxDistance));
+        entry[j] = nearT;
+        if(nearT <= farT) mask |= 1u << j;
+    }
+    return mask;
+}
+
+#endif
+
+void Raycast::Spread(const Ray& center, const glm::vec3& up, float spreadAngle, Ray* rays, size_t count)
+{
+    // Pellets per ring, the first ray always goes straight down the centre
+    const size_t RING_SIZE = 8;
+    if(count == 0) return;
+
+    glm::vec3 right = glm::normalize(glm::cross(center.direction, up));
+    glm::vec3 localUp = glm::cross(right, center.direction);
+    size_t rings = (count - 1 + RING_SIZE - 1) / RING_SIZE;
+
+    rays[0] = center;
+    for(size_t i = 1; i < count; i++)
+    {
+        size_t ring = (i - 1) / RING_SIZE + 1;
+        size_t slot = (i - 1) % RING_SIZE;
+
+        // Alternate rings are rotated half a slot so pellets do not line up
+        float cone = glm::radians(spreadAngle) * ring / rings;
+        float around = 2.0f * 3.14159265f * (slot + 0.5f * (ring % 2)) / RING_SIZE;
+        glm::vec3 offset = (right * std::cos(around) + localUp * std::sin(around)) * std::tan(cone);
+
+        rays[i] = Ray(center.origin, glm::normalize(center.direction + offset), center.maxDistance);
+    }
+}
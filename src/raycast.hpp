@@ -0,0 +1,89 @@
+#ifndef __RAYCAST_HPP__
+#define __RAYCAST_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+#include "collision.hpp"
+
+// Longest shot, anything further away is a miss
+const float MAX_RAY_DISTANCE = 100.0f;
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction; // Unit length
+    float maxDistance;
+
+    Ray() : origin(0.0f), direction(0.0f, 0.0f, -1.0f), maxDistance(MAX_RAY_DISTANCE) { }
+    Ray(glm::vec3 origin, glm::vec3 direction, float maxDistance = MAX_RAY_DISTANCE) : origin(origin), direction(direction), maxDistance(maxDistance) { }
+};
+
+enum HitKind
+{
+    HIT_NONE,
+    HIT_WALL,
+    HIT_TARGET,
+};
+
+// Closest hit along a ray, id is the index of the object within its kind
+struct RayHit
+{
+    float distance;
+    uint32_t id;
+    HitKind kind;
+
+    RayHit() : distance(MAX_RAY_DISTANCE), id(0), kind(HIT_NONE) { }
+    bool hit() const { return kind != HIT_NONE; }
+};
+
+// Spheres laid out structure of arrays, e.g. straight out of an entity pool
+struct SphereArrays
+{
+    const float *x, *y, *z, *radius;
+    size_t count;
+};
+
+// Flat panels laid out structure of arrays so four are intersected per SSE instruction
+class QuadArrays
+{
+    public:
+        std::vector<float> cx, cy, cz;
+        std::vector<float> nx, ny, nz;
+        std::vector<float> ux, uy, uz;
+        std::vector<float> vx, vy, vz;
+        std::vector<float> halfU, halfV;
+
+        void add(const CollisionQuad& quad);
+        void clear();
+        size_t size() const { return cx.size(); }
+};
+
+/**
+ * Static hit-scan intersection routines. Each one tests a single ray
+ * against a batch of objects four at a time with SSE (scalar fallback
+ * elsewhere) and only replaces the hit when something is closer, so a
+ * shot is resolved by running the batches of every kind into one RayHit.
+ */
+class Raycast
+{
+public:
+    // nearest sphere hit, a ray starting inside a sphere hits it at distance 0
+    static void IntersectSpheres(const Ray& ray, const SphereArrays& spheres, HitKind kind, RayHit& hit);
+    // nearest hit among the listed quads, both faces count
+    static void IntersectQuads(const Ray& ray, const QuadArrays& quads, const uint32_t* ids, size_t count, HitKind kind, RayHit& hit);
+    // slab test against up to four boxes, bit i of the result is set if box i is entered before maxDistance.
+    // entry receives the distance each box is entered at, inverseDirection is 1 / ray.direction
+    static unsigned int IntersectBoxes(const Ray& ray, const glm::vec3& inverseDirection, const AABB* boxes, size_t count, float maxDistance, float* entry);
+
+    // fills rays with a shotgun pattern around the centre ray: the centre plus rings of pellets
+    // spread evenly up to spreadAngle degrees. up must not be parallel to the centre direction
+    static void Spread(const Ray& center, const glm::vec3& up, float spreadAngle, Ray* rays, size_t count);
+private:
+    Raycast() { }
+};
+
+#endif
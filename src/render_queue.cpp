@@ -0,0 +1,128 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+
+#include "gl_ext.hpp"
+
+unsigned int RenderState::program = ~0u;
+unsigned int RenderState::activeUnit = ~0u;
+unsigned int RenderState::textures[MAX_TRACKED_TEXTURE_UNITS];
+unsigned int RenderState::VAO = ~0u;
+unsigned int RenderState::indirectBuffer = ~0u;
+
+// 0 is a real GL name, everything starts out unknown like after a Reset()
+static const bool stateUnknown = (RenderState::Reset(), true);
+
+void RenderState::UseProgram(unsigned int program)
+{
+    if(RenderState::program == program) return;
+    glUseProgram(program);
+    RenderState::program = program;
+}
+
+void RenderState::BindTexture(unsigned int unit, unsigned int texture)
+{
+    if(unit < MAX_TRACKED_TEXTURE_UNITS && textures[unit] == texture) return;
+
+    if(activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if(unit < MAX_TRACKED_TEXTURE_UNITS) textures[unit] = texture;
+}
+
+void RenderState::BindTextureArray(unsigned int unit, unsigned int texture)
+{
+    if(unit < MAX_TRACKED_TEXTURE_UNITS && textures[unit] == texture) return;
+
+    if(activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    if(unit < MAX_TRACKED_TEXTURE_UNITS) textures[unit] = texture;
+}
+
+void RenderState::BindVertexArray(unsigned int VAO)
+{
+    if(RenderState::VAO == VAO) return;
+    glBindVertexArray(VAO);
+    RenderState::VAO = VAO;
+}
+
+void RenderState::BindDrawIndirectBuffer(unsigned int buffer)
+{
+    if(indirectBuffer == buffer) return;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    indirectBuffer = buffer;
+}
+
+void RenderState::Reset()
+{
+    // ~0u never names a GL object, so the next bind always goes through
+    program = ~0u;
+    VAO = ~0u;
+    indirectBuffer = ~0u;
+    for(unsigned int i = 0; i < MAX_TRACKED_TEXTURE_UNITS; i++) textures[i] = ~0u;
+    activeUnit = ~0u;
+}
+
+/**
+ * Key layout, sorted ascending:
+ *   63..54  shader handle   (10 bits)
+ *   53..40  texture handle  (14 bits)
+ *   39..24  VAO             (16 bits)
+ *   23..0   depth           (24 bits, front to back)
+ */
+uint64_t RenderQueue::MakeKey(ShaderHandle shader, TextureHandle texture, unsigned int VAO, float depth)
+{
+    const float maxDepth = 1000.0f;
+    depth = std::min(std::max(depth, 0.0f), maxDepth);
+    uint64_t quantizedDepth = (uint64_t)(depth / maxDepth * 0xFFFFFF);
+
+    return ((uint64_t)(shader & 0x3FF) << 54)
+         | ((uint64_t)(texture & 0x3FFF) << 40)
+         | ((uint64_t)(VAO & 0xFFFF) << 24)
+         | quantizedDepth;
+}
+
+void RenderQueue::submit(const DrawItem& item, float depth)
+{
+    items.push_back(item);
+    items.back().key = MakeKey(item.shader, item.texture, item.VAO, depth);
+}
+
+void RenderQueue::flush()
+{
+    std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+
+    // Anything may have been bound since the last flush
+    RenderState::Reset();
+
+    for(const DrawItem& item: items)
+    {
+        const Shader &shader = ResourceManager::GetShader(item.shader);
+        RenderState::UseProgram(shader.ID);
+        if(item.modelUniform.Valid()) shader.Set(item.modelUniform, *item.model);
+
+        if(item.texture != INVALID_HANDLE) RenderState::BindTexture(0, ResourceManager::GetTexture(item.texture).ID);
+        if(item.materialTexture != 0) RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, item.materialTexture);
+
+        RenderState::BindVertexArray(item.VAO);
+        size_t indexSize = item.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        void *offset = (void *) (item.firstIndex * indexSize);
+        if(item.indirectBuffer != 0)
+        {
+            RenderState::BindDrawIndirectBuffer(item.indirectBuffer);
+            GLExt::MultiDrawElementsIndirect(GL_TRIANGLES, item.indexType, item.indirectOffset, item.drawCount, 0);
+        }
+        else if(item.drawCount > 0) glMultiDrawElements(GL_TRIANGLES, item.drawCounts, item.indexType, item.drawOffsets, item.drawCount);
+        else if(item.instanceCount > 1) glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, item.indexType, offset, item.instanceCount);
+        else glDrawElements(GL_TRIANGLES, item.indexCount, item.indexType, offset);
+    }
+
+    items.clear();
+}
@@ -0,0 +1,97 @@
+#ifndef __RENDER_QUEUE_HPP__
+#define __RENDER_QUEUE_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "resource_mgr.hpp"
+
+// Maximum texture units whose bindings are tracked
+const unsigned int MAX_TRACKED_TEXTURE_UNITS = 8;
+
+// A static mirror of the currently bound GL program, textures, vertex
+// array and indirect draw buffer. Every bind goes through here and is skipped when the object is
+// already bound. Call Reset() after binding anything behind its back.
+class RenderState
+{
+public:
+    static void UseProgram(unsigned int program);
+    static void BindTexture(unsigned int unit, unsigned int texture);
+    // same as BindTexture for GL_TEXTURE_2D_ARRAY, a unit should only ever be used for one of the two
+    static void BindTextureArray(unsigned int unit, unsigned int texture);
+    static void BindVertexArray(unsigned int VAO);
+    static void BindDrawIndirectBuffer(unsigned int buffer);
+    // forgets everything, the next bind of each kind always reaches the driver. Makes no GL calls
+    static void Reset();
+private:
+    RenderState() { }
+    static unsigned int program;
+    static unsigned int activeUnit;
+    static unsigned int textures[MAX_TRACKED_TEXTURE_UNITS];
+    static unsigned int VAO;
+    static unsigned int indirectBuffer;
+};
+
+// One record of a glMultiDrawElementsIndirect buffer, layout fixed by GL
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance; // must be 0 below GL 4.2
+};
+
+// A single indexed draw, everything needed to issue it without touching the object again
+struct DrawItem
+{
+    uint64_t key; // Filled in by RenderQueue::submit
+
+    ShaderHandle shader;
+    TextureHandle texture; // INVALID_HANDLE if untextured
+    unsigned int materialTexture = 0; // GL_TEXTURE_2D_ARRAY bound on MATERIAL_TEXTURE_UNIT, 0 if none
+    unsigned int VAO;
+
+    unsigned int indexCount;
+    unsigned int firstIndex;
+    unsigned int instanceCount; // 1 for a plain draw
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT for meshes packed with 16 bit indices
+
+    // Several index ranges of the same VAO in one glMultiDrawElements call, used instead of
+    // indexCount/firstIndex when drawCount is non zero. The arrays must stay alive until the queue is flushed
+    unsigned int drawCount = 0;
+    const GLsizei *drawCounts = nullptr;
+    const void * const *drawOffsets = nullptr;
+    // When set, the drawCount ranges are read from DrawElementsIndirectCommand records at indirectOffset in
+    // this buffer instead, with one glMultiDrawElementsIndirect. Only used where GLExt::MultiDrawIndirect
+    unsigned int indirectBuffer = 0;
+    const void *indirectOffset = nullptr;
+
+    Uniform<glm::mat4> modelUniform; // Left invalid for instanced draws, they carry their own transforms
+    const glm::mat4 *model; // Must stay alive until the queue is flushed
+};
+
+// Collects the draws of a frame, sorts them by a packed state key
+// (program, texture, VAO, depth) and issues them through RenderState so
+// consecutive draws sharing state do not rebind it.
+class RenderQueue
+{
+    private:
+        std::vector<DrawItem> items;
+
+    public:
+        // Packs the state into a sortable key, most expensive state change in the highest bits
+        static uint64_t MakeKey(ShaderHandle shader, TextureHandle texture, unsigned int VAO, float depth);
+
+        // Queues a draw, depth is the view distance used to order draws front to back within a state
+        void submit(const DrawItem& item, float depth);
+        // Sorts, draws and empties the queue
+        void flush();
+        void clear() { items.clear(); }
+
+        size_t size() const { return items.size(); }
+};
+
+#endif
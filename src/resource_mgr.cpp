@@ -4,52 +4,128 @@
 #include <sstream>
 #include <fstream>
 
+#include "texture_loader.hpp"
+#include "texture_cache.hpp"
+#include "gl_ext.hpp"
+
 #define STB_IMAGE_IMPLEMENTATION // Order of include matters
 #include "stb_image.h"
 
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+std::vector<Texture2D>    ResourceManager::Textures;
+std::vector<Shader>       ResourceManager::Shaders;
+std::vector<ShaderSource>  ResourceManager::ShaderSources;
+std::vector<TextureSource> ResourceManager::TextureSources;
+std::unordered_map<std::string, TextureHandle> ResourceManager::textureHandles;
+std::unordered_map<std::string, ShaderHandle>  ResourceManager::shaderHandles;
 
 
-Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
+ShaderHandle ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, const std::string &name)
 {
+    auto iter = shaderHandles.find(name);
+    if(iter != shaderHandles.end()) return iter->second;
 
-    if(Shaders.find(name) != Shaders.end()) return Shaders[name];
-
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+    ShaderHandle handle = Shaders.size();
+    Shaders.push_back(loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile));
+    ShaderSources.push_back({ vShaderFile, fShaderFile, gShaderFile != nullptr ? gShaderFile : "" });
+    shaderHandles[name] = handle;
     std::cout << "[DEBUG] Loaded shaders: " << vShaderFile << ", " << fShaderFile << std::endl;
-    return Shaders[name];
+    return handle;
 }
 
-Shader ResourceManager::GetShader(std::string name)
+ShaderHandle ResourceManager::FindShader(const std::string &name)
 {
-    return Shaders[name];
+    auto iter = shaderHandles.find(name);
+    if(iter == shaderHandles.end()) return INVALID_HANDLE;
+    return iter->second;
 }
 
-Texture2D ResourceManager::LoadTexture(const char *file, bool alpha, std::string name)
+TextureHandle ResourceManager::LoadTexture(const char *file, bool alpha, const std::string &name)
 {
+    auto iter = textureHandles.find(name);
+    if(iter != textureHandles.end()) return iter->second;
 
-    if(Textures.find(name) != Textures.end()) return Textures[name];
-
-    Textures[name] = loadTextureFromFile(file, alpha);
+    TextureHandle handle = Textures.size();
+    Textures.push_back(loadTextureFromFile(file, alpha));
+    TextureSources.push_back({ file, alpha });
+    textureHandles[name] = handle;
     std::cout << "[DEBUG] Successfully loaded: " << file << std::endl; 
-    return Textures[name];
+    return handle;
+}
+
+TextureHandle ResourceManager::LoadTextureAsync(const char *file, bool alpha, const std::string &name)
+{
+    auto iter = textureHandles.find(name);
+    if(iter != textureHandles.end()) return iter->second;
+
+    Texture2D texture;
+    if (alpha)
+    {
+        texture.Internal_Format = GL_RGBA;
+        texture.Image_Format = GL_RGBA;
+    }
+    TextureLoader::GeneratePlaceholder(texture);
+
+    TextureHandle handle = Textures.size();
+    Textures.push_back(texture);
+    TextureSources.push_back({ file, alpha });
+    textureHandles[name] = handle;
+    TextureLoader::Request(handle, file, alpha);
+    return handle;
 }
 
-Texture2D ResourceManager::GetTexture(std::string name)
+TextureHandle ResourceManager::FindTexture(const std::string &name)
 {
-    return Textures[name];
+    auto iter = textureHandles.find(name);
+    if(iter == textureHandles.end()) return INVALID_HANDLE;
+    return iter->second;
+}
+
+bool ResourceManager::ReloadShader(ShaderHandle handle)
+{
+    const ShaderSource &source = ShaderSources[handle];
+    Shader shader = loadShaderFromFile(source.vertex.c_str(), source.fragment.c_str(), source.geometry.empty() ? nullptr : source.geometry.c_str());
+    if (!shader.Linked())
+    {
+        // keep drawing with the last good program while the source is being fixed
+        glDeleteProgram(shader.ID);
+        std::cout << "ERROR::SHADER: Reload failed, keeping previous program: " << source.vertex << ", " << source.fragment << std::endl;
+        return false;
+    }
+
+    // handles stay valid: the slot stays, the program behind it changes
+    shader.AdoptUniforms(Shaders[handle]);
+    glDeleteProgram(Shaders[handle].ID);
+    Shaders[handle] = shader;
+    std::cout << "[DEBUG] Reloaded shaders: " << source.vertex << ", " << source.fragment << std::endl;
+    return true;
+}
+
+void ResourceManager::ReloadTexture(TextureHandle handle)
+{
+    // the cache sees the newer source and cooks it again, the upload reuses the texture object
+    const TextureSource &source = TextureSources[handle];
+    TextureLoader::Request(handle, source.file, source.alpha);
+    std::cout << "[DEBUG] Reloading texture: " << source.file << std::endl;
 }
 
 void ResourceManager::Clear()
 {
+    // stop decoding into textures that are about to disappear
+    TextureLoader::Shutdown();
     // (properly) delete all shaders	
-    for (auto iter : Shaders)
-        glDeleteProgram(iter.second.ID);
+    for (auto &shader : Shaders)
+        glDeleteProgram(shader.ID);
     // (properly) delete all textures
-    for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
+    for (auto &texture : Textures)
+        glDeleteTextures(1, &texture.ID);
+
+    Shaders.clear();
+    Textures.clear();
+    ShaderSources.clear();
+    TextureSources.clear();
+    shaderHandles.clear();
+    textureHandles.clear();
 }
 
 Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile)
@@ -105,14 +181,21 @@ Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha)
         texture.Internal_Format = GL_RGBA;
         texture.Image_Format = GL_RGBA;
     }
-    // load image
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
-    // now generate texture
-    texture.Generate(width, height, data);
-    std::cout << "[DEBUG] Loaded " << file << " with dimensions: (" << width << ", " << height << ")" << std::endl;
-    // and finally free image data
-    stbi_image_free(data);
+    // load the cooked mip chain, decoding and cooking the image on first use
+    CookedTexture cooked;
+    if (!TextureCache::Load(file, alpha, GLExt::TextureCompressionS3TC, cooked))
+    {
+        std::cout << "ERROR::TEXTURE: Failed to load " << file << std::endl;
+        TextureLoader::GeneratePlaceholder(texture);
+        return texture;
+    }
+    // now generate texture straight from the cache
+    texture.Internal_Format = TextureCache::InternalFormat(cooked.format);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    texture.GenerateLevels(cooked.levels.data(), cooked.levels.size(), cooked.format == COOKED_BC1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    std::cout << "[DEBUG] Loaded " << file << " with dimensions: (" << texture.Width << ", " << texture.Height << ")" << std::endl;
+    // and finally release the mapping
+    TextureCache::Release(cooked);
     return texture;
 }
-
@@ -1,39 +1,73 @@
 #ifndef __RESOURCE_MANAGER_HPP__
 #define __RESOURCE_MANAGER_HPP__
 
-#include <map>
+#include <vector>
 #include <string>
+#include <unordered_map>
 
 #include <glad/glad.h>
 
 #include "texture.hpp"
 #include "shader.hpp"
 
+// Resources are referred to by dense integer handles, names are only
+// resolved while loading
+typedef unsigned int ShaderHandle;
+typedef unsigned int TextureHandle;
+const unsigned int INVALID_HANDLE = ~0u;
+
+// Files a resource was built from, kept so it can be rebuilt in place
+struct ShaderSource
+{
+    std::string vertex, fragment, geometry; // geometry is empty when the program has none
+};
+struct TextureSource
+{
+    std::string file;
+    bool alpha;
+};
 
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
+// and/or shader is stored in a dense array and referenced by the
+// integer handle returned on load, so lookups in the frame loop are a
+// single indexed load. All functions and resources are static and no 
 // public constructor is defined.
 class ResourceManager
 {
 public:
-    // resource storage
-    static std::map<std::string, Shader>    Shaders;
-    static std::map<std::string, Texture2D> Textures;
-    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader    LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
+    // resource storage, indexed by handle
+    static std::vector<Shader>    Shaders;
+    static std::vector<Texture2D> Textures;
+    // where each resource came from, indexed by the same handles
+    static std::vector<ShaderSource>  ShaderSources;
+    static std::vector<TextureSource> TextureSources;
+    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader. Loading an existing name returns its handle
+    static ShaderHandle  LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, const std::string &name);
+    // resolves a shader name to its handle, INVALID_HANDLE if it was never loaded. Not meant for the frame loop
+    static ShaderHandle  FindShader(const std::string &name);
     // retrieves a stored shader
-    static Shader    GetShader(std::string name);
-    // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char *file, bool alpha, std::string name);
+    static const Shader    &GetShader(ShaderHandle handle) { return Shaders[handle]; }
+    // loads (and generates) a texture from file. Loading an existing name returns its handle
+    static TextureHandle LoadTexture(const char *file, bool alpha, const std::string &name);
+    // returns a handle to a placeholder texture right away, the file is decoded on a worker thread and replaces it in place once TextureLoader::Update uploads it
+    static TextureHandle LoadTextureAsync(const char *file, bool alpha, const std::string &name);
+    // resolves a texture name to its handle, INVALID_HANDLE if it was never loaded. Not meant for the frame loop
+    static TextureHandle FindTexture(const std::string &name);
     // retrieves a stored texture
-    static Texture2D GetTexture(std::string name);
+    static const Texture2D &GetTexture(TextureHandle handle) { return Textures[handle]; }
+    // recompiles a shader from its files and swaps it in under the same handle. On a compile or link error the old program is kept and false is returned
+    static bool      ReloadShader(ShaderHandle handle);
+    // decodes a texture's file again and streams it into the same texture object through the TextureLoader
+    static void      ReloadTexture(TextureHandle handle);
     // properly de-allocates all loaded resources
     static void      Clear();
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
+    // name -> handle, only consulted while loading
+    static std::unordered_map<std::string, ShaderHandle>  shaderHandles;
+    static std::unordered_map<std::string, TextureHandle> textureHandles;
     // loads and generates a shader from file
     static Shader    loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr);
     // loads a single texture from file
@@ -41,4 +75,3 @@ private:
 };
 
 #endif
-
@@ -0,0 +1,102 @@
+#include "scene.hpp"
+
+#include <algorithm>
+
+#include "hot_reload.hpp"
+
+void Scene::load(const std::string& levelFile)
+{
+    if(!this->level.openOrCompile(levelFile)) throw std::runtime_error("Failed to load level " + levelFile);
+
+    // Level materials map one to one onto the array's, a wall's material index is used as is
+    for(uint32_t i = 0; i < this->level.materialCount(); i++)
+        this->materials.add(this->level.materialTexture(i), false);
+    this->materials.build();
+    HotReload::WatchMaterials(&this->materials);
+
+    // Every material's shader is loaded once up front, so the walls only need its handle
+    std::vector<ShaderHandle> shaders(this->level.materialCount());
+    for(uint32_t i = 0; i < this->level.materialCount(); i++)
+    {
+        std::string name = this->level.materialShader(i);
+        shaders[i] = ResourceManager::LoadShader((name + ".vs").c_str(), (name + ".fs").c_str(), nullptr, name);
+    }
+
+    // One panel per wall record, read in place from the mapped file and fed straight into the
+    // batch, the collision world and the hierarchy. Walls never move, so no WallModel is made for them
+    const LevelWall *records = this->level.walls();
+    uint32_t wallCount = this->level.wallCount();
+    std::vector<AABB> bounds;
+    bounds.reserve(wallCount);
+    this->wallBatch.reserve(wallCount);
+    float quad[WALL_VERTEX_COUNT * FLOATS_PER_VERTEX];
+    for(uint32_t i = 0; i < wallCount; i++)
+    {
+        const LevelWall& wall = records[i];
+        glm::mat4 model = WallModel::Placement(glm::vec3(wall.center[0], wall.center[1], wall.center[2]),
+                                               glm::vec3(wall.normal[0], wall.normal[1], wall.normal[2]));
+        WallModel::GenerateQuad(wall.width, wall.height, quad);
+
+        // Merged into one draw call per shader
+        this->wallBatch.add(shaders[wall.material], quad, WALL_VERTEX_COUNT, WALL_INDICES, WALL_INDEX_COUNT, model, wall.material);
+
+        AABB box;
+        for(unsigned int v = 0; v < WALL_VERTEX_COUNT; v++)
+        {
+            const float *vertex = quad + v * FLOATS_PER_VERTEX;
+            box.extend(glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f)));
+        }
+        bounds.push_back(box);
+
+        CollisionQuad collisionQuad = WallModel::PlacedQuad(model, wall.width, wall.height);
+        this->collision.add(collisionQuad);
+        this->wallQuads.add(collisionQuad);
+    }
+    this->wallBatch.build(&this->materials);
+    this->wallTree.build(bounds);
+    this->collision.build();
+
+    std::cout << "[DEBUG] Built wall hierarchy: " << this->wallTree.nodeCount() << " nodes over " << bounds.size() << " walls" << std::endl;
+}
+
+void Scene::submit(RenderQueue& queue, const Frustum& frustum)
+{
+    this->visible.clear();
+    this->wallTree.cull(frustum, this->visible);
+
+    // The batch merges neighbouring ids, which only works in order
+    std::sort(this->visible.begin(), this->visible.end());
+    this->wallBatch.submit(queue, this->visible);
+}
+
+void Scene::raycast(const Ray* rays, size_t count, RayHit* hits) const
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        this->wallTree.raycast(rays[i], hits[i], [this, rays, i](const uint32_t* ids, uint32_t idCount, RayHit& hit) {
+            Raycast::IntersectQuads(rays[i], this->wallQuads, ids, idCount, HIT_WALL, hit);
+        });
+    }
+}
+
+void Scene::clear()
+{
+    this->wallTree.clear();
+    this->collision.clear();
+    this->wallQuads.clear();
+    this->wallBatch.clear();
+    HotReload::UnwatchMaterials(&this->materials);
+    this->materials.clear();
+    this->level.close();
+}
+
+bool Scene::getSpawn(unsigned int index, glm::vec3& position, float& yaw, float& pitch) const
+{
+    if(index >= this->level.spawnCount()) return false;
+
+    const LevelSpawn& spawn = this->level.spawns()[index];
+    position = glm::vec3(spawn.position[0], spawn.position[1], spawn.position[2]);
+    yaw = spawn.yaw;
+    pitch = spawn.pitch;
+    return true;
+}
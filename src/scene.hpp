@@ -0,0 +1,56 @@
+#ifndef __SCENE_HPP__
+#define __SCENE_HPP__
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <glm/glm.hpp>
+
+#include "wall_model.hpp"
+#include "static_batch.hpp"
+#include "material_array.hpp"
+#include "render_queue.hpp"
+#include "level.hpp"
+#include "frustum.hpp"
+#include "bvh.hpp"
+#include "collision.hpp"
+#include "raycast.hpp"
+
+// The arena the player trains in, built from a level file. Owns the static
+// batch the wall panels are drawn from and the structures they are hit and
+// collided through, shared by the game and the benchmark.
+class Scene
+{
+    public:
+        Level level;
+        // Every material texture of the level, so the walls share one texture and one draw per shader
+        MaterialArray materials;
+        StaticBatch wallBatch;
+        // Hierarchy over the wall bounds, item ids are the wall batch ids
+        BVH wallTree;
+        // Keeps the player inside the walls
+        CollisionWorld collision;
+        // Wall panels by wall id, what shots are tested against
+        QuadArrays wallQuads;
+
+        // Builds the level (authoring .txt, compiled to .lvl on first use) and uploads its batches, needs a current GL context
+        void load(const std::string& levelFile);
+        // Player start from the level, false if it has none with that index
+        bool getSpawn(unsigned int index, glm::vec3& position, float& yaw, float& pitch) const;
+        // Queues everything inside the view frustum
+        void submit(RenderQueue& queue, const Frustum& frustum);
+        // Closest wall along each ray, hits[i] is only replaced by something nearer than it already holds
+        void raycast(const Ray* rays, size_t count, RayHit* hits) const;
+        // Box around every wall of the level
+        AABB getBounds() const { return wallTree.bounds(); }
+        // Number of walls that passed culling in the last submit
+        size_t visibleCount() const { return visible.size(); }
+        // Releases the GL objects, must be called while the context is alive
+        void clear();
+
+    private:
+        std::vector<uint32_t> visible; // Reused every frame
+};
+
+#endif
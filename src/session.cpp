@@ -0,0 +1,126 @@
+#include "session.hpp"
+
+#include <cstring>
+#include <iostream>
+
+static const char SESSION_MAGIC[4] = { 'A', 'S', 'E', 'S' };
+static const uint32_t SESSION_VERSION = 1;
+
+bool SessionRecorder::open(const std::string& file, const std::string& level, uint32_t tickRate, uint32_t seed)
+{
+    // The path has to fit with its terminator, a truncated one would replay on the wrong level
+    if(level.size() >= sizeof(this->header.level))
+    {
+        std::cout << "ERROR::SESSION: Level path " << level << " is longer than " << sizeof(this->header.level) - 1
+                  << " bytes, not recording" << std::endl;
+        return false;
+    }
+
+    this->out.open(file, std::ios::binary | std::ios::trunc);
+    if(!this->out)
+    {
+        std::cout << "ERROR::SESSION: Failed to open " << file << " for recording" << std::endl;
+        return false;
+    }
+
+    std::memset(&this->header, 0, sizeof(this->header));
+    std::memcpy(this->header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    this->header.version = SESSION_VERSION;
+    this->header.tickRate = tickRate;
+    this->header.seed = seed;
+    std::memcpy(this->header.level, level.c_str(), level.size());
+
+    this->out.write((const char *) &this->header, sizeof(this->header));
+    std::cout << "[DEBUG] Recording session to " << file << std::endl;
+    return true;
+}
+
+void SessionRecorder::record(const TickInput& input)
+{
+    if(!this->out.is_open()) return;
+
+    bool motion = input.dx != 0.0f || input.dy != 0.0f;
+    uint8_t flags = input.keys | (motion ? TICK_HAS_MOTION : 0);
+    this->out.put((char) flags);
+    if(motion)
+    {
+        this->out.write((const char *) &input.dx, sizeof(float));
+        this->out.write((const char *) &input.dy, sizeof(float));
+    }
+    this->header.tickCount++;
+}
+
+void SessionRecorder::close(const SessionResult& result)
+{
+    if(!this->out.is_open()) return;
+
+    this->out.write((const char *) &result, sizeof(result));
+
+    // The tick count marks the log as complete, patch it in last
+    this->out.seekp(0);
+    this->out.write((const char *) &this->header, sizeof(this->header));
+    this->out.close();
+
+    std::cout << "[DEBUG] Recorded " << this->header.tickCount << " ticks" << std::endl;
+}
+
+bool SessionReplay::open(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if(!in)
+    {
+        std::cout << "ERROR::SESSION: Failed to open " << file << " for replay" << std::endl;
+        return false;
+    }
+
+    size_t size = in.tellg();
+    in.seekg(0);
+    this->data.resize(size);
+    in.read(this->data.data(), size);
+
+    if(size < sizeof(SessionHeader))
+    {
+        std::cout << "ERROR::SESSION: " << file << " is too small to be a session log" << std::endl;
+        return false;
+    }
+    std::memcpy(&this->header, this->data.data(), sizeof(SessionHeader));
+    if(std::memcmp(this->header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0 || this->header.version != SESSION_VERSION)
+    {
+        std::cout << "ERROR::SESSION: " << file << " is not a version " << SESSION_VERSION << " session log" << std::endl;
+        return false;
+    }
+
+    // A cleanly closed log ends with the final state, otherwise every byte after the header is ticks
+    this->hasResult = this->header.tickCount > 0 && size >= sizeof(SessionHeader) + sizeof(SessionResult);
+    this->end = size;
+    if(this->hasResult)
+    {
+        this->end = size - sizeof(SessionResult);
+        std::memcpy(&this->result, this->data.data() + this->end, sizeof(SessionResult));
+    }
+
+    this->offset = sizeof(SessionHeader);
+    this->tick = 0;
+    return true;
+}
+
+bool SessionReplay::next(TickInput& input)
+{
+    if(this->hasResult && this->tick >= this->header.tickCount) return false;
+    if(this->offset >= this->end) return false;
+
+    uint8_t flags = (uint8_t) this->data[this->offset++];
+    input.keys = flags & ~TICK_HAS_MOTION;
+    input.dx = input.dy = 0.0f;
+    if(flags & TICK_HAS_MOTION)
+    {
+        // A log cut off mid record ends here
+        if(this->offset + 2 * sizeof(float) > this->end) return false;
+        std::memcpy(&input.dx, this->data.data() + this->offset, sizeof(float));
+        std::memcpy(&input.dy, this->data.data() + this->offset + sizeof(float), sizeof(float));
+        this->offset += 2 * sizeof(float);
+    }
+
+    this->tick++;
+    return true;
+}
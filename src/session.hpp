@@ -0,0 +1,96 @@
+#ifndef __SESSION_HPP__
+#define __SESSION_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+/**
+ * Session log layout (little endian):
+ *   SessionHeader
+ *   one record per simulation tick:
+ *     uint8 flags        TickKey bits, TICK_HAS_MOTION if mouse deltas follow
+ *     float dx, dy       only with TICK_HAS_MOTION
+ *   SessionResult        only if the session was closed cleanly
+ * Ticks without mouse motion cost a single byte.
+ */
+
+// Buttons held during a tick, everything the simulation reads from the keyboard and mouse
+enum TickKey
+{
+    TICK_FORWARD  = 1 << 0,
+    TICK_BACKWARD = 1 << 1,
+    TICK_LEFT     = 1 << 2,
+    TICK_RIGHT    = 1 << 3,
+    TICK_SPRINT   = 1 << 4,
+    TICK_FIRE     = 1 << 5,
+    TICK_SHOTGUN  = 1 << 6,
+};
+const uint8_t TICK_HAS_MOTION = 1 << 7;
+
+// The input of one simulation tick
+struct TickInput
+{
+    uint8_t keys;
+    float dx, dy;
+};
+
+struct SessionHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t tickRate;
+    uint32_t seed;       // Target spawner seed
+    uint64_t tickCount;  // 0 if the session was not closed cleanly
+    char level[128];     // Level file the session was played on
+};
+
+// Final simulation state, compared bit for bit at the end of a replay
+struct SessionResult
+{
+    float position[3];
+    float yaw, pitch;
+    uint32_t hits, misses;
+};
+
+// Streams tick inputs to a session log while playing
+class SessionRecorder
+{
+    private:
+        std::ofstream out;
+        SessionHeader header;
+
+    public:
+        bool open(const std::string& file, const std::string& level, uint32_t tickRate, uint32_t seed);
+        void record(const TickInput& input);
+        // Writes the final state and the tick count, the log is only replay checked if this ran
+        void close(const SessionResult& result);
+        bool isOpen() const { return out.is_open(); }
+};
+
+// Reads a session log back one tick at a time
+class SessionReplay
+{
+    private:
+        std::vector<char> data;
+        size_t offset, end;
+        uint64_t tick;
+        SessionHeader header;
+        SessionResult result;
+        bool hasResult;
+
+    public:
+        bool open(const std::string& file);
+        // The next tick's input, false once every recorded tick was played
+        bool next(TickInput& input);
+
+        const SessionHeader& getHeader() const { return header; }
+        // Whether the recorded final state is available to check against
+        bool hasExpectedResult() const { return hasResult; }
+        const SessionResult& getExpectedResult() const { return result; }
+        uint64_t ticksPlayed() const { return tick; }
+};
+
+#endif
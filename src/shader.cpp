@@ -2,14 +2,27 @@
 
 #include <iostream>
 
-Shader &Shader::Use()
+#include "shader_cache.hpp"
+#include "render_queue.hpp"
+
+const Shader &Shader::Use() const
 {
-    glUseProgram(this->ID);
+    // Through the tracker, so draws relying on it never skip a program bind that is needed
+    RenderState::UseProgram(this->ID);
     return *this;
 }
 
 void Shader::Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
 {
+    // try the program binary cache first, compiling is the slow part of startup
+    std::string cacheKey = ShaderCache::Key(vertexSource, fragmentSource, geometrySource);
+    this->ID = glCreateProgram();
+    if (ShaderCache::Load(this->ID, cacheKey))
+    {
+        this->cacheUniforms();
+        return;
+    }
+    // on a miss (or a binary rejected by the driver) the same program is built from source
     unsigned int sVertex, sFragment, gShader;
     // vertex Shader
     sVertex = glCreateShader(GL_VERTEX_SHADER);
@@ -30,13 +43,15 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
         checkCompileErrors(gShader, "GEOMETRY");
     }
     // shader program
-    this->ID = glCreateProgram();
     glAttachShader(this->ID, sVertex);
     glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
+    ShaderCache::PrepareForStore(this->ID);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    ShaderCache::Store(this->ID, cacheKey);
+    this->cacheUniforms();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
@@ -44,61 +59,174 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
         glDeleteShader(gShader);
 }
 
-void Shader::SetFloat(const char *name, float value, bool useShader)
+void Shader::SetFloat(const char *name, float value, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    glUniform1f(this->GetUniformLocation(name), value);
 }
-void Shader::SetInteger(const char *name, int value, bool useShader)
+void Shader::SetInteger(const char *name, int value, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    glUniform1i(this->GetUniformLocation(name), value);
 }
-void Shader::SetVector2f(const char *name, float x, float y, bool useShader)
+void Shader::SetVector2f(const char *name, float x, float y, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    glUniform2f(this->GetUniformLocation(name), x, y);
 }
-void Shader::SetVector2f(const char *name, const glm::vec2 &value, bool useShader)
+void Shader::SetVector2f(const char *name, const glm::vec2 &value, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform2f(this->GetUniformLocation(name), value.x, value.y);
 }
-void Shader::SetVector3f(const char *name, float x, float y, float z, bool useShader)
+void Shader::SetVector3f(const char *name, float x, float y, float z, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform3f(this->GetUniformLocation(name), x, y, z);
 }
-void Shader::SetVector3f(const char *name, const glm::vec3 &value, bool useShader)
+void Shader::SetVector3f(const char *name, const glm::vec3 &value, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform3f(this->GetUniformLocation(name), value.x, value.y, value.z);
 }
-void Shader::SetVector4f(const char *name, float x, float y, float z, float w, bool useShader)
+void Shader::SetVector4f(const char *name, float x, float y, float z, float w, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform4f(this->GetUniformLocation(name), x, y, z, w);
 }
-void Shader::SetVector4f(const char *name, const glm::vec4 &value, bool useShader)
+void Shader::SetVector4f(const char *name, const glm::vec4 &value, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(this->GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
-void Shader::SetMatrix4(const char *name, const glm::mat4 &matrix, bool useShader)
+void Shader::SetMatrix4(const char *name, const glm::mat4 &matrix, bool useShader) const
 {
     if (useShader)
         this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    glUniformMatrix4fv(this->GetUniformLocation(name), 1, false, glm::value_ptr(matrix));
+}
+
+void Shader::Set(Uniform<float> uniform, float value) const
+{
+    if(uniform.Slot < 0) return; // unresolved handles are ignored, like GL does location -1
+    glUniform1f(this->slotLocations[uniform.Slot], value);
+}
+void Shader::Set(Uniform<int> uniform, int value) const
+{
+    if(uniform.Slot < 0) return;
+    glUniform1i(this->slotLocations[uniform.Slot], value);
+}
+void Shader::Set(Uniform<glm::vec2> uniform, const glm::vec2 &value) const
+{
+    if(uniform.Slot < 0) return;
+    glUniform2f(this->slotLocations[uniform.Slot], value.x, value.y);
+}
+void Shader::Set(Uniform<glm::vec3> uniform, const glm::vec3 &value) const
+{
+    if(uniform.Slot < 0) return;
+    glUniform3f(this->slotLocations[uniform.Slot], value.x, value.y, value.z);
+}
+void Shader::Set(Uniform<glm::vec4> uniform, const glm::vec4 &value) const
+{
+    if(uniform.Slot < 0) return;
+    glUniform4f(this->slotLocations[uniform.Slot], value.x, value.y, value.z, value.w);
+}
+void Shader::Set(Uniform<glm::mat4> uniform, const glm::mat4 &matrix) const
+{
+    if(uniform.Slot < 0) return;
+    glUniformMatrix4fv(this->slotLocations[uniform.Slot], 1, false, glm::value_ptr(matrix));
+}
+
+int Shader::GetUniformLocation(const char *name) const
+{
+    auto iter = this->uniformLocations.find(name);
+    if (iter == this->uniformLocations.end())
+        return -1;
+    return iter->second;
 }
 
+int Shader::resolveSlot(const char *name) const
+{
+    int location = this->GetUniformLocation(name);
+    if (location == -1)
+        return -1;
+    // a uniform resolved twice shares its slot
+    for (size_t i = 0; i < this->slotNames.size(); i++)
+        if (this->slotNames[i] == name)
+            return i;
+    this->slotNames.push_back(name);
+    this->slotLocations.push_back(location);
+    return this->slotNames.size() - 1;
+}
+
+bool Shader::Linked() const
+{
+    int success = 0;
+    glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+void Shader::AdoptUniforms(const Shader &previous)
+{
+    // slots keep their index, only the location behind them moves. A uniform the
+    // new source dropped resolves to -1, which GL silently ignores
+    this->slotNames = previous.slotNames;
+    this->slotLocations.resize(this->slotNames.size());
+    for (size_t i = 0; i < this->slotNames.size(); i++)
+        this->slotLocations[i] = this->GetUniformLocation(this->slotNames[i].c_str());
+}
+
+void Shader::cacheUniforms()
+{
+    this->uniformLocations.clear();
+
+    int count = 0, maxLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength, '\0');
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0, size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(this->ID, i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName = name.substr(0, length);
+
+        // uniforms inside blocks have no location, they are fed through buffers
+        int location = glGetUniformLocation(this->ID, uniformName.c_str());
+        if (location == -1)
+            continue;
+
+        // arrays are reported as "name[0]", also allow lookups by the bare name
+        this->uniformLocations[uniformName] = location;
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+            this->uniformLocations[uniformName.substr(0, bracket)] = location;
+    }
+
+    // attach the shared camera matrices if this program declares them
+    unsigned int cameraBlock = glGetUniformBlockIndex(this->ID, CAMERA_BLOCK_NAME);
+    if (cameraBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->ID, cameraBlock, CAMERA_BLOCK_BINDING);
+    unsigned int materialBlock = glGetUniformBlockIndex(this->ID, MATERIAL_BLOCK_NAME);
+    if (materialBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->ID, materialBlock, MATERIAL_BLOCK_BINDING);
+    // samplers default to unit 0, the material array has its own so it never collides with a 2D texture
+    int materialSampler = this->GetUniformLocation(MATERIAL_SAMPLER_NAME);
+    if (materialSampler != -1)
+    {
+        RenderState::UseProgram(this->ID);
+        glUniform1i(materialSampler, MATERIAL_TEXTURE_UNIT);
+    }
+}
 
 void Shader::checkCompileErrors(unsigned int object, std::string type)
 {
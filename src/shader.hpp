@@ -2,12 +2,34 @@
 #define __SHADER_HPP__
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 
+// Every program declaring this std140 block gets it bound to the shared camera UBO (see CameraUniforms)
+const char * const  CAMERA_BLOCK_NAME    = "Camera";
+const unsigned int  CAMERA_BLOCK_BINDING = 0;
+// Likewise for the material regions of a MaterialArray, whose texture array is read through this sampler and unit
+const char * const  MATERIAL_BLOCK_NAME    = "Materials";
+const unsigned int  MATERIAL_BLOCK_BINDING = 1;
+const char * const  MATERIAL_SAMPLER_NAME  = "materials";
+const unsigned int  MATERIAL_TEXTURE_UNIT  = 1;
+
+// Typed handle to a uniform, resolved once from the program's cache so the
+// hot loop never touches uniform names. It indexes the program's slot table
+// rather than holding the location itself, so it survives a hot reload
+// relinking the program with a different layout.
+template<typename T>
+struct Uniform
+{
+    int Slot = -1;
+    bool Valid() const { return Slot != -1; }
+};
+
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
 // functions for easy management.
@@ -19,20 +41,45 @@ public:
     // constructor
     Shader() { }
     // sets the current shader as active
-    Shader  &Use();
+    const Shader  &Use() const;
     // compiles the shader from given source code
     void    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr); // note: geometry source code is optional 
+    // returns the cached location of a uniform, -1 if the program does not use it
+    int     GetUniformLocation(const char *name) const;
+    // resolves a typed handle for the given uniform
+    template<typename T>
+    Uniform<T> GetUniform(const char *name) const { Uniform<T> uniform; uniform.Slot = resolveSlot(name); return uniform; }
+    // true if the last Compile produced a linked program
+    bool    Linked() const;
+    // takes over the uniform handles given out by a previous build of this program, re-resolved against the new layout
+    void    AdoptUniforms(const Shader &previous);
     // utility functions
-    void    SetFloat    (const char *name, float value, bool useShader = false);
-    void    SetInteger  (const char *name, int value, bool useShader = false);
-    void    SetVector2f (const char *name, float x, float y, bool useShader = false);
-    void    SetVector2f (const char *name, const glm::vec2 &value, bool useShader = false);
-    void    SetVector3f (const char *name, float x, float y, float z, bool useShader = false);
-    void    SetVector3f (const char *name, const glm::vec3 &value, bool useShader = false);
-    void    SetVector4f (const char *name, float x, float y, float z, float w, bool useShader = false);
-    void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false);
-    void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false);
+    void    SetFloat    (const char *name, float value, bool useShader = false) const;
+    void    SetInteger  (const char *name, int value, bool useShader = false) const;
+    void    SetVector2f (const char *name, float x, float y, bool useShader = false) const;
+    void    SetVector2f (const char *name, const glm::vec2 &value, bool useShader = false) const;
+    void    SetVector3f (const char *name, float x, float y, float z, bool useShader = false) const;
+    void    SetVector3f (const char *name, const glm::vec3 &value, bool useShader = false) const;
+    void    SetVector4f (const char *name, float x, float y, float z, float w, bool useShader = false) const;
+    void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false) const;
+    void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false) const;
+    // handle based setters, the program must be in use
+    void    Set         (Uniform<float> uniform, float value) const;
+    void    Set         (Uniform<int> uniform, int value) const;
+    void    Set         (Uniform<glm::vec2> uniform, const glm::vec2 &value) const;
+    void    Set         (Uniform<glm::vec3> uniform, const glm::vec3 &value) const;
+    void    Set         (Uniform<glm::vec4> uniform, const glm::vec4 &value) const;
+    void    Set         (Uniform<glm::mat4> uniform, const glm::mat4 &matrix) const;
 private:
+    // uniform name -> location, filled once after linking
+    std::unordered_map<std::string, int> uniformLocations;
+    // locations behind the Uniform handles given out so far, and the names to re-resolve them by
+    mutable std::vector<int>         slotLocations;
+    mutable std::vector<std::string> slotNames;
+    // hands out a slot for a uniform, -1 if the program does not use it
+    int     resolveSlot(const char *name) const;
+    // queries every active uniform of the linked program and binds known uniform blocks
+    void    cacheUniforms();
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type); 
 };
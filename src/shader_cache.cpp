@@ -0,0 +1,135 @@
+#include "shader_cache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/stat.h>
+
+#include "gl_ext.hpp"
+
+std::string ShaderCache::Directory = "cache/shaders";
+
+// Bump whenever the file layout changes
+static const uint32_t CACHE_VERSION = 1;
+static const char CACHE_MAGIC[4] = { 'A', 'S', 'H', 'B' };
+
+struct BinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+// 64 bit FNV-1a, sources are hashed once per program at load time
+static uint64_t hashString(uint64_t hash, const char *text)
+{
+    if (text == nullptr)
+        text = "";
+    for (; *text; text++)
+    {
+        hash ^= (unsigned char)*text;
+        hash *= 1099511628211ull;
+    }
+    // separator so "ab"+"c" and "a"+"bc" differ
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+std::string ShaderCache::Key(const char *vertexSource, const char *fragmentSource, const char *geometrySource)
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashString(hash, vertexSource);
+    hash = hashString(hash, fragmentSource);
+    hash = hashString(hash, geometrySource);
+    hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+std::string ShaderCache::path(const std::string &key)
+{
+    return Directory + "/" + key + ".bin";
+}
+
+bool ShaderCache::Load(unsigned int program, const std::string &key)
+{
+    if (!GLExt::ProgramBinary)
+        return false;
+
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    BinaryHeader header;
+    if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION)
+        return false;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+        return false;
+
+    // the driver may still refuse the binary, e.g. after an update that kept the version string
+    GLExt::ProgramBinaryLoad(program, header.binaryFormat, binary.data(), binary.size());
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+void ShaderCache::PrepareForStore(unsigned int program)
+{
+    if (GLExt::ProgramBinary)
+        GLExt::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ShaderCache::Store(unsigned int program, const std::string &key)
+{
+    if (!GLExt::ProgramBinary)
+        return;
+
+    int success = 0, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!success || length <= 0)
+        return;
+
+    BinaryHeader header;
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    GLExt::GetProgramBinary(program, length, &written, &binaryFormat, binary.data());
+    header.binaryFormat = binaryFormat;
+    header.length = written;
+
+    // mkdir -p
+    for (size_t slash = Directory.find('/'); ; slash = Directory.find('/', slash + 1))
+    {
+        mkdir(Directory.substr(0, slash).c_str(), 0755);
+        if (slash == std::string::npos)
+            break;
+    }
+
+    // Written aside and renamed so a crash never leaves a truncated binary behind
+    std::string target = path(key), tmp = target + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary);
+        if (!file.write((const char *)&header, sizeof(header)) || !file.write(binary.data(), written))
+        {
+            std::cout << "[DEBUG] Could not write shader cache " << target << std::endl;
+            return;
+        }
+    }
+    std::rename(tmp.c_str(), target.c_str());
+}
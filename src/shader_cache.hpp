@@ -0,0 +1,32 @@
+#ifndef __SHADER_CACHE_HPP__
+#define __SHADER_CACHE_HPP__
+
+#include <string>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// A static on-disk cache of linked program binaries. Entries are keyed
+// by a hash of the shader sources plus the driver's vendor, renderer and
+// version strings, so a driver update or an edited shader simply misses
+// and falls back to compiling from source.
+class ShaderCache
+{
+public:
+    // where program binaries are stored, relative to the working directory
+    static std::string Directory;
+
+    // cache key for the given stages, geometrySource may be nullptr
+    static std::string Key(const char *vertexSource, const char *fragmentSource, const char *geometrySource);
+    // loads a cached binary into the (freshly created) program, false if missing or rejected by the driver
+    static bool Load(unsigned int program, const std::string &key);
+    // asks the driver to keep the binary retrievable, call before linking
+    static void PrepareForStore(unsigned int program);
+    // saves the linked program's binary
+    static void Store(unsigned int program, const std::string &key);
+private:
+    ShaderCache() { }
+    static std::string path(const std::string &key);
+};
+
+#endif
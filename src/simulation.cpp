@@ -0,0 +1,60 @@
+#include "simulation.hpp"
+
+#include <iostream>
+
+PlayerState PlayerState::Capture(const Camera& camera)
+{
+    PlayerState state;
+    state.position = camera.Position;
+    state.yaw = camera.Yaw;
+    state.pitch = camera.Pitch;
+    return state;
+}
+
+PlayerState PlayerState::Interpolate(const PlayerState& from, const PlayerState& to, float alpha)
+{
+    PlayerState state;
+    state.position = from.position + (to.position - from.position) * alpha;
+    state.yaw = from.yaw + (to.yaw - from.yaw) * alpha;
+    state.pitch = from.pitch + (to.pitch - from.pitch) * alpha;
+    return state;
+}
+
+FixedTimestep::FixedTimestep(unsigned int tickRate)
+{
+    if(tickRate == 0) tickRate = DEFAULT_TICK_RATE;
+    this->tickLength = 1.0 / tickRate;
+    this->accumulator = 0.0;
+    this->lastTime = 0.0;
+    this->started = false;
+    this->tick = 0;
+
+    std::cout << "[DEBUG] Simulation running at " << tickRate << " Hz" << std::endl;
+}
+
+unsigned int FixedTimestep::advance(double now)
+{
+    // The first call only sets the clock, nothing has elapsed yet
+    if(!this->started)
+    {
+        this->lastTime = now;
+        this->started = true;
+        return 0;
+    }
+
+    this->accumulator += now - this->lastTime;
+    this->lastTime = now;
+
+    unsigned int ticks = 0;
+    while(this->accumulator >= this->tickLength && ticks < MAX_TICKS_PER_FRAME)
+    {
+        this->accumulator -= this->tickLength;
+        ticks++;
+    }
+
+    // Still behind after the cap, forget the backlog rather than catching up over the next frames
+    if(this->accumulator >= this->tickLength) this->accumulator = 0.0;
+
+    this->tick += ticks;
+    return ticks;
+}
@@ -0,0 +1,53 @@
+#ifndef __SIMULATION_HPP__
+#define __SIMULATION_HPP__
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+
+// Default simulation rate, every movement and aim update happens on these ticks
+const unsigned int DEFAULT_TICK_RATE = 128;
+// Ticks run in one frame at most, a long stall drops time instead of spiralling
+const unsigned int MAX_TICKS_PER_FRAME = 64;
+
+// The simulated part of the player, snapshotted after every tick
+struct PlayerState
+{
+    glm::vec3 position;
+    float yaw, pitch;
+
+    static PlayerState Capture(const Camera& camera);
+    // alpha 0 gives from, 1 gives to
+    static PlayerState Interpolate(const PlayerState& from, const PlayerState& to, float alpha);
+};
+
+// Turns variable frame times into a whole number of fixed length ticks.
+// The remainder is carried over in an accumulator and exposed as alpha,
+// how far the renderer is between the last two simulated states.
+class FixedTimestep
+{
+    private:
+        double tickLength;
+        double accumulator;
+        double lastTime;
+        bool started;
+        uint64_t tick;
+
+    public:
+        FixedTimestep(unsigned int tickRate = DEFAULT_TICK_RATE);
+
+        // Adds the real time elapsed up to now (seconds) and returns how many ticks to run
+        unsigned int advance(double now);
+
+        // Real time (same clock as advance) up to which the index-th of the last advance's ticks simulates
+        double tickEndTime(unsigned int index, unsigned int ticks) const { return lastTime - accumulator - (ticks - 1 - index) * tickLength; }
+        // Seconds simulated by one tick
+        float dt() const { return (float) tickLength; }
+        // Fraction of a tick left in the accumulator, in [0, 1)
+        float alpha() const { return (float) (accumulator / tickLength); }
+        // Ticks handed out since construction
+        uint64_t tickCount() const { return tick; }
+};
+
+#endif
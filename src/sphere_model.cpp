@@ -0,0 +1,89 @@
+#include "sphere_model.hpp"
+
+#include <cmath>
+
+SphereModel::SphereModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float radius, glm::vec3 center_pos, bool batched)
+: ObjectModel(shaderName, textureName, useEBO, useTexture, batched)
+{
+    if ( !useEBO ) throw std::runtime_error("Spheres should use element buffers");
+    if ( radius <= 0.0f ) throw std::runtime_error("Sphere radius must be positive");
+
+    this->radius = radius;
+    this->center_pos = center_pos;
+
+    this->generateGeometry();
+    this->init();
+}
+
+void SphereModel::generateGeometry()
+{
+    const float PI = 3.14159265f;
+
+    // Unit sphere, the radius is applied by the model matrix so instances can scale it freely
+    for(unsigned int ring = 0; ring <= SPHERE_RINGS; ring++)
+    {
+        float v = (float) ring / SPHERE_RINGS;
+        float phi = v * PI;
+        for(unsigned int sector = 0; sector <= SPHERE_SECTORS; sector++)
+        {
+            float u = (float) sector / SPHERE_SECTORS;
+            float theta = u * 2.0f * PI;
+            this->vertices.push_back(std::cos(theta) * std::sin(phi));
+            this->vertices.push_back(std::cos(phi));
+            this->vertices.push_back(std::sin(theta) * std::sin(phi));
+            this->vertices.push_back(u);
+            this->vertices.push_back(v);
+        }
+    }
+
+    for(unsigned int ring = 0; ring < SPHERE_RINGS; ring++)
+    {
+        for(unsigned int sector = 0; sector < SPHERE_SECTORS; sector++)
+        {
+            unsigned int first = ring * (SPHERE_SECTORS + 1) + sector;
+            unsigned int second = first + SPHERE_SECTORS + 1;
+            this->indices.insert(this->indices.end(), { first, second, first + 1, second, second + 1, first + 1 });
+        }
+    }
+}
+
+void SphereModel::init()
+{
+    this->shader = ResourceManager::LoadShader((this->shaderName + ".vs").c_str(), (this->shaderName + ".fs").c_str(), nullptr, this->shaderName);
+    if(useTexture) this->texture = ResourceManager::LoadTextureAsync(this->textureName.c_str(), false, this->textureName);
+
+    const Shader &shader = ResourceManager::GetShader(this->shader);
+    this->modelUniform = shader.GetUniform<glm::mat4>("model");
+    if(useTexture) shader.SetInteger("tex", 0, true);
+
+    // Batched spheres are uploaded by whoever batches them
+    if(batched) return;
+
+    this->uploadGeometry();
+}
+
+void SphereModel::setCenter(glm::vec3 center_pos)
+{
+    this->center_pos = center_pos;
+    this->markTransformDirty();
+}
+
+glm::mat4 SphereModel::computeModelMatrix() const
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), this->center_pos);
+    return glm::scale(model, glm::vec3(this->radius));
+}
+
+void SphereModel::draw()
+{
+    if(batched) throw std::runtime_error("Batched spheres are drawn by their batch");
+
+    const Shader &shader = ResourceManager::GetShader(this->shader);
+    RenderState::UseProgram(shader.ID);
+    shader.Set(this->modelUniform, this->getModelMatrix());
+
+    if(useTexture) RenderState::BindTexture(0, ResourceManager::GetTexture(this->texture).ID);
+
+    RenderState::BindVertexArray(this->VAO);
+    glDrawElements(GL_TRIANGLES, indices.size(), this->indexType, 0);
+}
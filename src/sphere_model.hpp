@@ -0,0 +1,33 @@
+#ifndef __SPHERE_MODEL_HPP__
+#define __SPHERE_MODEL_HPP__
+
+#include "object_model.hpp"
+
+// Latitude/longitude subdivision of the generated sphere
+const unsigned int SPHERE_RINGS = 12;
+const unsigned int SPHERE_SECTORS = 16;
+
+// A UV sphere around center_pos. Used on its own or, batched, as the
+// prototype an InstancedMesh copies its geometry from.
+class SphereModel : public ObjectModel
+{
+    private:
+        float radius;
+        glm::vec3 center_pos;
+
+    protected:
+        void generateGeometry();
+        void init();
+        glm::mat4 computeModelMatrix() const override;
+
+    public:
+        SphereModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float radius, glm::vec3 center_pos, bool batched = false);
+        void draw();
+
+        // Moving the sphere invalidates the cached model matrix
+        void setCenter(glm::vec3 center_pos);
+        glm::vec3 getCenter() const { return center_pos; }
+        float getRadius() const { return radius; }
+};
+
+#endif
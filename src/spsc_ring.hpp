@@ -0,0 +1,48 @@
+#ifndef __SPSC_RING_HPP__
+#define __SPSC_RING_HPP__
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed capacity, lock free queue for exactly one producer thread and one
+// consumer thread. Capacity must be a power of two. Head and tail are kept
+// on separate cache lines so the two sides do not false share.
+template<typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    private:
+        T items[Capacity];
+        alignas(64) std::atomic<size_t> head{0}; // Next slot to write, owned by the producer
+        alignas(64) std::atomic<size_t> tail{0}; // Next slot to read, owned by the consumer
+
+    public:
+        // Producer side, false if the ring is full
+        bool push(const T& item)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) == Capacity) return false;
+            items[h & (Capacity - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, the item offset places after the oldest without removing it, nullptr past the newest
+        const T* peek(size_t offset = 0) const
+        {
+            size_t t = tail.load(std::memory_order_relaxed) + offset;
+            if(t >= head.load(std::memory_order_acquire)) return nullptr;
+            return &items[t & (Capacity - 1)];
+        }
+
+        // Consumer side, drops the item returned by peek()
+        void pop()
+        {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
+
+#endif
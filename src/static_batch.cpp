@@ -0,0 +1,307 @@
+#include "static_batch.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+#include "gl_ext.hpp"
+
+StaticBatch::StaticBatch()
+{
+    this->built = false;
+    this->useIndirect = false;
+}
+
+uint32_t StaticBatch::findBatch(ShaderHandle shader, TextureHandle texture, bool useTexture, bool useMaterials)
+{
+    // Material objects only need to agree on the shader, their textures all live in the array
+    for(uint32_t i = 0; i < this->batches.size(); i++)
+    {
+        const Batch& batch = this->batches[i];
+        if(batch.shader == shader && batch.useTexture == useTexture && batch.useMaterials == useMaterials
+            && (!useTexture || batch.texture == texture))
+            return i;
+    }
+
+    Batch batch;
+    batch.shader = shader;
+    batch.texture = useTexture ? texture : INVALID_HANDLE;
+    batch.useTexture = useTexture;
+    batch.useMaterials = useMaterials;
+    batch.materialTexture = 0;
+    batch.VAO = batch.VBO = batch.EBO = 0;
+    batch.indexCount = 0;
+    batch.indexType = GL_UNSIGNED_INT;
+    batch.indexSize = sizeof(unsigned int);
+    batch.model = glm::mat4(1.0f);
+    this->batches.push_back(batch);
+    return this->batches.size() - 1;
+}
+
+uint32_t StaticBatch::add(const ObjectModel& object, uint32_t material)
+{
+    if(this->built) throw std::runtime_error("Cannot add objects to a StaticBatch after it is built");
+
+    bool useMaterials = material != NO_MATERIAL;
+    uint32_t batchIndex = this->findBatch(object.getShader(), object.getTexture(), object.usesTexture() && !useMaterials, useMaterials);
+    const std::vector<float>& vertices = object.getVertices();
+    const std::vector<unsigned int>& indices = object.getIndices();
+    return this->addGeometry(batchIndex, vertices.data(), vertices.size() / FLOATS_PER_VERTEX, indices.data(), indices.size(),
+                             object.getModelMatrix(), material);
+}
+
+uint32_t StaticBatch::add(ShaderHandle shader, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                          const glm::mat4& model, uint32_t material)
+{
+    if(this->built) throw std::runtime_error("Cannot add objects to a StaticBatch after it is built");
+    if(material == NO_MATERIAL) throw std::runtime_error("Geometry added without an ObjectModel needs a material");
+
+    uint32_t batchIndex = this->findBatch(shader, INVALID_HANDLE, false, true);
+    return this->addGeometry(batchIndex, vertices, vertexCount, indices, indexCount, model, material);
+}
+
+uint32_t StaticBatch::addGeometry(uint32_t batchIndex, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                                  const glm::mat4& model, uint32_t material)
+{
+    Batch& batch = this->batches[batchIndex];
+
+    // Indices of this object start after the vertices already in the batch
+    unsigned int baseVertex = batch.vertices.size() / BATCH_FLOATS_PER_VERTEX;
+
+    // Bake the model matrix into the positions so every object in the batch shares one model
+    float materialAttribute = material == NO_MATERIAL ? 0.0f : (float)(material + 1);
+    for(size_t v = 0; v < vertexCount; v++)
+    {
+        const float *vertex = vertices + v * FLOATS_PER_VERTEX;
+        glm::vec4 pos = model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f);
+        batch.vertices.push_back(pos.x);
+        batch.vertices.push_back(pos.y);
+        batch.vertices.push_back(pos.z);
+        batch.vertices.push_back(vertex[3]);
+        batch.vertices.push_back(vertex[4]);
+        batch.vertices.push_back(materialAttribute);
+    }
+
+    ObjectRange range;
+    range.batch = batchIndex;
+    range.firstIndex = batch.indices.size();
+    range.indexCount = indexCount;
+    this->objects.push_back(range);
+
+    for(size_t i = 0; i < indexCount; i++) batch.indices.push_back(baseVertex + indices[i]);
+
+    return this->objects.size() - 1;
+}
+
+void StaticBatch::build(const MaterialArray* materials)
+{
+    for(auto& batch: this->batches)
+    {
+        if(batch.useMaterials)
+        {
+            if(materials == nullptr) throw std::runtime_error("StaticBatch objects have materials but no MaterialArray was given");
+            batch.materialTexture = materials->getTexture();
+        }
+
+        // Quantize positions over the batch's own bounds instead of the whole float range, the model
+        // matrix scales them back. A level spanning 100 units keeps a precision of about 0.002
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        for(size_t i = 0; i < batch.vertices.size(); i += BATCH_FLOATS_PER_VERTEX)
+        {
+            glm::vec3 pos(batch.vertices[i], batch.vertices[i + 1], batch.vertices[i + 2]);
+            minimum = i == 0 ? pos : glm::min(minimum, pos);
+            maximum = i == 0 ? pos : glm::max(maximum, pos);
+        }
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        glm::vec3 extent = glm::max((maximum - minimum) * 0.5f, glm::vec3(1e-6f));
+        for(size_t i = 0; i < batch.vertices.size(); i += BATCH_FLOATS_PER_VERTEX)
+            for(unsigned int c = 0; c < 3; c++)
+            {
+                // Rounding lands the extremes just past ±1, which would push the whole batch to half floats
+                float normalized = (batch.vertices[i + c] - center[c]) / extent[c];
+                batch.vertices[i + c] = std::min(std::max(normalized, -1.0f), 1.0f);
+            }
+        batch.model = glm::scale(glm::translate(glm::mat4(1.0f), center), extent);
+
+        PackedMesh mesh = MeshPacker::Pack(batch.vertices.data(), batch.vertices.size() / BATCH_FLOATS_PER_VERTEX, BATCH_VERTEX_LAYOUT, BATCH_VERTEX_ELEMENTS,
+                                           batch.indices.data(), batch.indices.size());
+        batch.indexType = mesh.indexType;
+        batch.indexSize = mesh.indexSize();
+
+        glGenVertexArrays(1, &batch.VAO);
+        glGenBuffers(1, &batch.VBO);
+        glGenBuffers(1, &batch.EBO);
+
+        RenderState::BindVertexArray(batch.VAO);
+        MeshPacker::Upload(mesh, batch.VBO, batch.EBO);
+        RenderState::BindVertexArray(0);
+
+        // Resolve uniforms once, the sampler always reads unit 0
+        const Shader &shader = ResourceManager::GetShader(batch.shader);
+        batch.modelUniform = shader.GetUniform<glm::mat4>("model");
+        if(batch.useTexture) shader.SetInteger("tex", 0, true);
+
+        // The GPU owns the geometry now, drop the CPU copy
+        batch.indexCount = batch.indices.size();
+        std::vector<float>().swap(batch.vertices);
+        std::vector<unsigned int>().swap(batch.indices);
+
+        std::cout << "[DEBUG] Built static batch: shader " << batch.shader << ", " << (batch.useMaterials ? "materials" : "texture " + std::to_string(batch.texture)) << " with " << batch.indexCount / 3 << " triangles, " << mesh.stride << " bytes per vertex" << std::endl;
+    }
+
+    // A command per object is the most a frame can produce, merging only ever makes fewer
+    if(GLExt::MultiDrawIndirect && !this->objects.empty())
+    {
+        this->indirectBuffer.init(GL_DRAW_INDIRECT_BUFFER, this->objects.size() * sizeof(DrawElementsIndirectCommand));
+        this->commands.reserve(this->objects.size());
+        this->useIndirect = true;
+    }
+
+    this->built = true;
+}
+
+void StaticBatch::draw()
+{
+    if(!this->built) throw std::runtime_error("StaticBatch must be built before drawing");
+
+    for(auto& batch: this->batches)
+    {
+        const Shader &shader = ResourceManager::GetShader(batch.shader);
+        RenderState::UseProgram(shader.ID);
+        shader.Set(batch.modelUniform, batch.model);
+
+        if(batch.useTexture) RenderState::BindTexture(0, ResourceManager::GetTexture(batch.texture).ID);
+        if(batch.useMaterials) RenderState::BindTextureArray(MATERIAL_TEXTURE_UNIT, batch.materialTexture);
+
+        RenderState::BindVertexArray(batch.VAO);
+        glDrawElements(GL_TRIANGLES, batch.indexCount, batch.indexType, 0);
+    }
+}
+
+void StaticBatch::submit(RenderQueue& queue) const
+{
+    if(!this->built) throw std::runtime_error("StaticBatch must be built before drawing");
+
+    for(auto& batch: this->batches)
+    {
+        DrawItem item;
+        item.shader = batch.shader;
+        item.texture = batch.useTexture ? batch.texture : INVALID_HANDLE;
+        item.materialTexture = batch.materialTexture;
+        item.VAO = batch.VAO;
+        item.indexCount = batch.indexCount;
+        item.firstIndex = 0;
+        item.instanceCount = 1;
+        item.indexType = batch.indexType;
+        item.modelUniform = batch.modelUniform;
+        item.model = &batch.model;
+
+        // A batch spans the whole level, it has no meaningful depth
+        queue.submit(item, 0.0f);
+    }
+}
+
+void StaticBatch::submit(RenderQueue& queue, const std::vector<uint32_t>& visible)
+{
+    if(!this->built) throw std::runtime_error("StaticBatch must be built before drawing");
+
+    for(auto& batch: this->batches)
+    {
+        batch.drawCounts.clear();
+        batch.drawOffsets.clear();
+    }
+
+    // Objects added one after another sit next to each other in their batch's index buffer,
+    // so a run of visible ids usually collapses into a single range
+    for(uint32_t id: visible)
+    {
+        const ObjectRange& range = this->objects[id];
+        Batch& batch = this->batches[range.batch];
+        const void *offset = (const void *) ((size_t) range.firstIndex * batch.indexSize);
+
+        if(!batch.drawCounts.empty())
+        {
+            uintptr_t end = (uintptr_t) batch.drawOffsets.back() + batch.drawCounts.back() * batch.indexSize;
+            if(end == (uintptr_t) offset)
+            {
+                batch.drawCounts.back() += range.indexCount;
+                continue;
+            }
+        }
+        batch.drawCounts.push_back(range.indexCount);
+        batch.drawOffsets.push_back(offset);
+    }
+
+    // Turn the ranges into indirect commands, every batch's records back to back in one upload
+    bool indirect = false;
+    size_t commandOffset = 0;
+    if(this->useIndirect && !visible.empty())
+    {
+        this->commands.clear();
+        for(auto& batch: this->batches)
+        {
+            for(size_t i = 0; i < batch.drawCounts.size(); i++)
+            {
+                GLuint firstIndex = (GLuint) ((uintptr_t) batch.drawOffsets[i] / batch.indexSize);
+                this->commands.push_back({ (GLuint) batch.drawCounts[i], 1, firstIndex, 0, 0 });
+            }
+        }
+
+        // This frame's section of the stream buffer, last frame's records may still be read
+        size_t size = this->commands.size() * sizeof(DrawElementsIndirectCommand);
+        void *mapped = this->indirectBuffer.map(size);
+        if(mapped != nullptr)
+        {
+            memcpy(mapped, this->commands.data(), size);
+            this->indirectBuffer.unmap();
+            commandOffset = this->indirectBuffer.offset();
+            indirect = true;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        if(mapped == nullptr) std::cout << "ERROR::STATIC_BATCH: Failed to map the indirect buffer, drawing without it" << std::endl;
+    }
+
+    size_t firstCommand = 0;
+    for(auto& batch: this->batches)
+    {
+        if(batch.drawCounts.empty()) continue;
+
+        DrawItem item;
+        item.shader = batch.shader;
+        item.texture = batch.useTexture ? batch.texture : INVALID_HANDLE;
+        item.materialTexture = batch.materialTexture;
+        item.VAO = batch.VAO;
+        item.indexCount = 0;
+        item.firstIndex = 0;
+        item.instanceCount = 1;
+        item.indexType = batch.indexType;
+        item.drawCount = batch.drawCounts.size();
+        item.drawCounts = batch.drawCounts.data();
+        item.drawOffsets = batch.drawOffsets.data();
+        if(indirect)
+        {
+            item.indirectBuffer = this->indirectBuffer.getBuffer();
+            item.indirectOffset = (const void *) (commandOffset + firstCommand * sizeof(DrawElementsIndirectCommand));
+            firstCommand += batch.drawCounts.size();
+        }
+        item.modelUniform = batch.modelUniform;
+        item.model = &batch.model;
+
+        queue.submit(item, 0.0f);
+    }
+}
+
+void StaticBatch::clear()
+{
+    for(auto& batch: this->batches)
+    {
+        glDeleteVertexArrays(1, &batch.VAO);
+        glDeleteBuffers(1, &batch.VBO);
+        glDeleteBuffers(1, &batch.EBO);
+    }
+    this->indirectBuffer.destroy();
+    this->useIndirect = false;
+    this->batches.clear();
+    this->objects.clear();
+    this->commands.clear();
+    this->built = false;
+}
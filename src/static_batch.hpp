@@ -0,0 +1,115 @@
+#ifndef __STATIC_BATCH_HPP__
+#define __STATIC_BATCH_HPP__
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "resource_mgr.hpp"
+#include "object_model.hpp"
+#include "render_queue.hpp"
+#include "material_array.hpp"
+#include "stream_buffer.hpp"
+
+// Objects added without a material keep their own texture
+const uint32_t NO_MATERIAL = ~0u;
+// Batched vertices carry the object's vertex plus its material index + 1, 0 meaning none
+const unsigned int BATCH_FLOATS_PER_VERTEX = FLOATS_PER_VERTEX + 1;
+// Positions are normalized to the batch's bounds before packing, so they always land in snorm16
+const VertexElement BATCH_VERTEX_LAYOUT[] = {
+    { 0, 3, ATTRIB_POSITION },
+    { 1, 2, ATTRIB_TEXCOORD },
+    { 2, 1, ATTRIB_INDEX },
+};
+const size_t BATCH_VERTEX_ELEMENTS = sizeof(BATCH_VERTEX_LAYOUT) / sizeof(VertexElement);
+
+// Merges static objects that share a shader and texture into a single
+// pre-transformed vertex/index buffer at load time, packed by MeshPacker. Each group is then
+// drawn with one glDrawElements call instead of one call per object.
+// Objects given a material of a MaterialArray share one group per shader
+// whatever their texture, the shader picks the texture per vertex.
+class StaticBatch
+{
+    private:
+        struct Batch
+        {
+            ShaderHandle shader;
+            TextureHandle texture;
+            bool useTexture;
+            bool useMaterials;
+            unsigned int materialTexture; // The MaterialArray's texture, 0 without materials
+
+            std::vector<float> vertices; // World space, ObjectModel::vertices followed by the material
+            std::vector<unsigned int> indices;
+
+            unsigned int VAO, VBO, EBO;
+            unsigned int indexCount;
+            GLenum indexType;
+            unsigned int indexSize; // Bytes per index, for turning ranges into buffer offsets
+            glm::mat4 model; // Maps the normalized packed positions back onto the batch's world space bounds
+
+            Uniform<glm::mat4> modelUniform;
+
+            // Visible index ranges of the current frame, rebuilt by each culled submit
+            std::vector<GLsizei> drawCounts;
+            std::vector<const void *> drawOffsets;
+        };
+
+        // Where an added object's indices ended up
+        struct ObjectRange
+        {
+            uint32_t batch;
+            unsigned int firstIndex;
+            unsigned int indexCount;
+        };
+
+        std::vector<Batch> batches;
+        std::vector<ObjectRange> objects;
+        bool built;
+
+        // Where multi draw indirect is available the culled ranges of every batch are written here as
+        // DrawElementsIndirectCommand records, batch after batch, each frame into its own section.
+        // Sized for every object at build time
+        bool useIndirect;
+        StreamBuffer indirectBuffer;
+        std::vector<DrawElementsIndirectCommand> commands;
+
+        uint32_t findBatch(ShaderHandle shader, TextureHandle texture, bool useTexture, bool useMaterials);
+        uint32_t addGeometry(uint32_t batchIndex, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                             const glm::mat4& model, uint32_t material);
+
+    public:
+        StaticBatch();
+
+        // Appends the object's geometry, transformed by its model matrix, to the matching batch.
+        // With a material the object is textured from the MaterialArray given to build() instead of its own texture.
+        // Returns the object's id, ids count up from 0 in the order objects are added
+        uint32_t add(const ObjectModel& object, uint32_t material = NO_MATERIAL);
+        // Same for geometry that has no ObjectModel, vertices are laid out like ObjectModel::vertices
+        // and textured from the material
+        uint32_t add(ShaderHandle shader, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                     const glm::mat4& model, uint32_t material);
+        // Room for this many objects' ranges, so adding them does not reallocate
+        void reserve(size_t objectCount) { objects.reserve(objectCount); }
+        // Uploads every batch to the GPU, no objects can be added afterwards. Needs the built
+        // MaterialArray if any object was added with a material
+        void build(const MaterialArray* materials = nullptr);
+        // One draw call per shader + texture group, camera matrices come from CameraUniforms
+        void draw();
+        // Queues one draw item per shader + texture group instead of drawing immediately
+        void submit(RenderQueue& queue) const;
+        // Queues only the given objects, ids sorted ascending. Neighbouring ids are merged into
+        // one index range and each group is drawn with a single glMultiDrawElementsIndirect, or
+        // glMultiDrawElements on contexts without it
+        void submit(RenderQueue& queue, const std::vector<uint32_t>& visible);
+        // Deletes the GL buffers, must be called while the context is alive
+        void clear();
+
+        size_t batchCount() const { return batches.size(); }
+        size_t objectCount() const { return objects.size(); }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "stream_buffer.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "gl_ext.hpp"
+
+GLsync StreamBuffer::fences[STREAM_BUFFER_FRAMES] = { nullptr };
+unsigned int StreamBuffer::frame = 0;
+
+// Waiting longer than this for a section means the GPU is gone, give up rather than hang
+static const GLuint64 FENCE_TIMEOUT = 1000000000; // 1 s in nanoseconds
+
+StreamBuffer::StreamBuffer()
+{
+    this->target = GL_ARRAY_BUFFER;
+    this->buffer = 0;
+    this->sectionSize = 0;
+    this->frameOffset = 0;
+    this->mapping = nullptr;
+}
+
+void StreamBuffer::BeginFrame()
+{
+    GLsync &fence = fences[frame % STREAM_BUFFER_FRAMES];
+    if(fence == nullptr) return;
+
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    if(result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+        std::cout << "ERROR::STREAM_BUFFER: Gave up waiting for frame " << frame << " to be free" << std::endl;
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::EndFrame()
+{
+    GLsync &fence = fences[frame % STREAM_BUFFER_FRAMES];
+    if(fence != nullptr) glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame++;
+}
+
+void StreamBuffer::Clear()
+{
+    for(GLsync &fence: fences)
+    {
+        if(fence != nullptr) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    frame = 0;
+}
+
+void StreamBuffer::init(GLenum target, size_t frameCapacity)
+{
+    this->destroy();
+    this->target = target;
+
+    // Uniform ranges can only be bound at aligned offsets, keep every section start on one
+    size_t alignment = 4;
+    if(target == GL_UNIFORM_BUFFER)
+    {
+        int uniformAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        if(uniformAlignment > 0) alignment = uniformAlignment;
+    }
+    this->sectionSize = (frameCapacity + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &this->buffer);
+    glBindBuffer(this->target, this->buffer);
+    if(GLExt::BufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        size_t size = this->sectionSize * STREAM_BUFFER_FRAMES;
+        GLExt::BufferStorageAlloc(this->target, size, nullptr, flags);
+        this->mapping = (unsigned char *)glMapBufferRange(this->target, 0, size, flags);
+        if(this->mapping == nullptr) throw std::runtime_error("Failed to persistently map a stream buffer");
+    }
+    else
+        glBufferData(this->target, this->sectionSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(this->target, 0);
+}
+
+void *StreamBuffer::map(size_t size)
+{
+    if(size > this->sectionSize) throw std::runtime_error("Stream buffer write larger than its capacity");
+
+    glBindBuffer(this->target, this->buffer);
+    if(this->mapping != nullptr)
+    {
+        this->frameOffset = (frame % STREAM_BUFFER_FRAMES) * this->sectionSize;
+        return this->mapping + this->frameOffset;
+    }
+
+    // Orphan, the draws still reading the old storage keep it alive on their own
+    this->frameOffset = 0;
+    glBufferData(this->target, this->sectionSize, nullptr, GL_STREAM_DRAW);
+    return glMapBufferRange(this->target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+void StreamBuffer::unmap()
+{
+    // A coherent mapping needs nothing, the fence orders the writes before the GPU reads
+    if(this->mapping == nullptr) glUnmapBuffer(this->target);
+}
+
+void StreamBuffer::destroy()
+{
+    if(this->buffer == 0) return;
+
+    if(this->mapping != nullptr)
+    {
+        glBindBuffer(this->target, this->buffer);
+        glUnmapBuffer(this->target);
+        glBindBuffer(this->target, 0);
+    }
+    glDeleteBuffers(1, &this->buffer);
+    this->buffer = 0;
+    this->mapping = nullptr;
+    this->sectionSize = 0;
+    this->frameOffset = 0;
+}
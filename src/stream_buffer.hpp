@@ -0,0 +1,66 @@
+#ifndef __STREAM_BUFFER_HPP__
+#define __STREAM_BUFFER_HPP__
+
+#include <cstddef>
+#include <glad/glad.h>
+
+// Frames whose stream data can be in flight at once, each gets its own section of every StreamBuffer
+const unsigned int STREAM_BUFFER_FRAMES = 3;
+
+/**
+ * A buffer for data rewritten every frame (instance transforms, uniforms,
+ * indirect commands) that never makes the CPU wait on the GPU reading an
+ * earlier frame's copy.
+ *
+ * With GL 4.4 / ARB_buffer_storage the buffer holds STREAM_BUFFER_FRAMES
+ * sections and stays persistently and coherently mapped, frame n writes
+ * straight into section n % STREAM_BUFFER_FRAMES. BeginFrame() waits on the
+ * fence EndFrame() placed when that section was last used, which only
+ * blocks if the GPU is a whole ring of frames behind.
+ * On 3.3 every map() orphans the buffer instead, the driver hands out fresh
+ * storage while the old one is still read, and offset() is always 0.
+ *
+ * Fences are shared by every StreamBuffer, so BeginFrame() and EndFrame()
+ * are called once per frame around all of them. Each buffer is written at
+ * most once per frame.
+ */
+class StreamBuffer
+{
+    private:
+        GLenum target;
+        unsigned int buffer;
+        size_t sectionSize; // Bytes per frame, rounded up to the target's offset alignment
+        size_t frameOffset; // Where this frame's data starts
+        unsigned char *mapping; // Persistent mapping of the whole buffer, nullptr when orphaning
+
+        static GLsync fences[STREAM_BUFFER_FRAMES];
+        static unsigned int frame;
+
+    public:
+        StreamBuffer();
+
+        // Waits until this frame's sections are no longer read by the GPU, call before writing any StreamBuffer
+        static void BeginFrame();
+        // Fences this frame's sections, call once everything reading them has been submitted
+        static void EndFrame();
+        // Deletes the fences, must be called while the context is alive
+        static void Clear();
+        // Counts up in EndFrame(), sections are reused every STREAM_BUFFER_FRAMES frames
+        static unsigned int CurrentFrame() { return frame; }
+
+        // Allocates room for frameCapacity bytes per frame
+        void init(GLenum target, size_t frameCapacity);
+        // Returns where up to size bytes of this frame's data go, the buffer is left bound to its target
+        void *map(size_t size);
+        // Makes the written data visible to the GPU
+        void unmap();
+        // Deletes the buffer, must be called while the context is alive
+        void destroy();
+
+        unsigned int getBuffer() const { return buffer; }
+        // Byte offset of the data written by the last map()
+        size_t offset() const { return frameOffset; }
+        size_t capacity() const { return sectionSize; }
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "targets.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// Dead slots never intersect a ray
+static const float DEAD_RADIUS = -1.0f;
+// Targets keep this far from the arena walls, floor and ceiling
+static const float ARENA_MARGIN = 0.2f;
+
+// Clamps value to [low, high], or the middle of the range if it is empty
+static float fitInside(float value, float low, float high)
+{
+    if(low > high) return (low + high) * 0.5f;
+    return std::min(std::max(value, low), high);
+}
+
+TargetPool::TargetPool()
+{
+    for(std::vector<float>* array: { &x, &y, &z, &radius, &previousX, &previousY, &previousZ, &originX, &originY, &originZ,
+                                     &axisX, &axisZ, &amplitude, &speed, &phase, &age, &lifetime })
+        array->assign(MAX_TARGETS, 0.0f);
+    this->radius.assign(MAX_TARGETS, DEAD_RADIUS);
+    this->pattern.assign(MAX_TARGETS, PATTERN_STATIC);
+    this->alive.assign(MAX_TARGETS, 0);
+    this->freeSlots.reserve(MAX_TARGETS);
+
+    this->used = 0;
+    this->count = 0;
+    this->hits = this->misses = 0;
+    this->arena = AABB(glm::vec3(-1.0f), glm::vec3(1.0f));
+    this->spawnRate = TARGET_SPAWN_RATE;
+    this->spawnTimer = 0.0f;
+    this->random = 0x9E3779B9u;
+}
+
+void TargetPool::init()
+{
+    // Unit sphere, every target scales it by its own radius
+    this->prototype = std::make_unique<SphereModel>("shaders/target", "", true, false, 1.0f, glm::vec3(0.0f), true);
+    this->mesh = std::make_unique<InstancedMesh>(*this->prototype);
+}
+
+float TargetPool::nextRandom()
+{
+    this->random ^= this->random << 13;
+    this->random ^= this->random >> 17;
+    this->random ^= this->random << 5;
+    return (this->random >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32_t TargetPool::spawn(const glm::vec3& position, TargetPattern pattern, float radius, float lifetime)
+{
+    uint32_t slot;
+    if(!this->freeSlots.empty())
+    {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+    else if(this->used < MAX_TARGETS) slot = this->used++;
+    else return MAX_TARGETS;
+
+    this->radius[slot] = radius;
+    this->pattern[slot] = pattern;
+    this->lifetime[slot] = lifetime;
+    this->age[slot] = 0.0f;
+
+    // Motion parameters are drawn even for static targets so the random sequence does not depend on the pattern
+    float angle = this->nextRandom() * 6.2831853f;
+    this->axisX[slot] = std::cos(angle);
+    this->axisZ[slot] = std::sin(angle);
+    this->amplitude[slot] = 0.1f + 0.2f * this->nextRandom();
+    this->speed[slot] = 1.5f + 2.5f * this->nextRandom();
+    this->phase[slot] = this->nextRandom() * 6.2831853f;
+
+    // Moving targets swing up to amplitude from their origin on each horizontal axis, keep the
+    // whole path and the sphere around it inside the arena so no wall ever covers the target
+    float reach = radius + (pattern == PATTERN_STATIC ? 0.0f : this->amplitude[slot]);
+    this->originX[slot] = fitInside(position.x, this->arena.min.x + reach, this->arena.max.x - reach);
+    this->originY[slot] = fitInside(position.y, this->arena.min.y + radius, this->arena.max.y - radius);
+    this->originZ[slot] = fitInside(position.z, this->arena.min.z + reach, this->arena.max.z - reach);
+
+    this->alive[slot] = 1;
+    this->count++;
+
+    this->place(slot);
+    this->previousX[slot] = this->x[slot];
+    this->previousY[slot] = this->y[slot];
+    this->previousZ[slot] = this->z[slot];
+    return slot;
+}
+
+uint32_t TargetPool::spawnRandom()
+{
+    glm::vec3 low = this->arena.min + glm::vec3(ARENA_MARGIN);
+    glm::vec3 high = this->arena.max - glm::vec3(ARENA_MARGIN);
+    glm::vec3 position(
+        low.x + (high.x - low.x) * this->nextRandom(),
+        low.y + (high.y - low.y) * this->nextRandom(),
+        low.z + (high.z - low.z) * this->nextRandom()
+    );
+    TargetPattern pattern = (TargetPattern) ((uint32_t) (this->nextRandom() * PATTERN_COUNT) % PATTERN_COUNT);
+    return this->spawn(position, pattern);
+}
+
+void TargetPool::despawn(uint32_t slot)
+{
+    if(slot >= this->used || !this->alive[slot]) return;
+
+    this->alive[slot] = 0;
+    this->radius[slot] = DEAD_RADIUS;
+    this->freeSlots.push_back(slot);
+    this->count--;
+}
+
+bool TargetPool::hit(uint32_t slot)
+{
+    if(slot >= this->used || !this->alive[slot]) return false;
+    this->despawn(slot);
+    this->hits++;
+    return true;
+}
+
+void TargetPool::place(uint32_t slot)
+{
+    float t = this->age[slot] * this->speed[slot] + this->phase[slot];
+    float px = this->originX[slot], pz = this->originZ[slot];
+
+    switch(this->pattern[slot])
+    {
+        case PATTERN_STRAFE:
+            px += this->axisX[slot] * this->amplitude[slot] * std::sin(t);
+            pz += this->axisZ[slot] * this->amplitude[slot] * std::sin(t);
+            break;
+        case PATTERN_CIRCLE:
+            px += this->amplitude[slot] * std::cos(t);
+            pz += this->amplitude[slot] * std::sin(t);
+            break;
+        default:
+            break;
+    }
+
+    this->x[slot] = px;
+    this->y[slot] = this->originY[slot];
+    this->z[slot] = pz;
+}
+
+void TargetPool::update(float dt)
+{
+    for(uint32_t slot = 0; slot < this->used; slot++)
+    {
+        if(!this->alive[slot]) continue;
+
+        this->previousX[slot] = this->x[slot];
+        this->previousY[slot] = this->y[slot];
+        this->previousZ[slot] = this->z[slot];
+
+        this->age[slot] += dt;
+        if(this->age[slot] >= this->lifetime[slot])
+        {
+            this->despawn(slot);
+            this->misses++;
+            continue;
+        }
+        this->place(slot);
+    }
+
+    // Whole spawns owed by the accumulated time, several per tick at high rates
+    if(this->spawnRate <= 0.0f) return;
+    this->spawnTimer += dt * this->spawnRate;
+    while(this->spawnTimer >= 1.0f)
+    {
+        this->spawnTimer -= 1.0f;
+        this->spawnRandom();
+    }
+}
+
+void TargetPool::raycast(const Ray* rays, size_t rayCount, RayHit* hits) const
+{
+    SphereArrays spheres = { this->x.data(), this->y.data(), this->z.data(), this->radius.data(), this->used };
+    for(size_t i = 0; i < rayCount; i++) Raycast::IntersectSpheres(rays[i], spheres, HIT_TARGET, hits[i]);
+}
+
+void TargetPool::submit(RenderQueue& queue, float alpha)
+{
+    if(!this->mesh) return;
+
+    // Rebuilt every frame, the instance array keeps its capacity so this does not allocate
+    this->mesh->clearInstances();
+    for(uint32_t slot = 0; slot < this->used; slot++)
+    {
+        if(!this->alive[slot]) continue;
+
+        glm::vec3 previous(this->previousX[slot], this->previousY[slot], this->previousZ[slot]);
+        glm::vec3 current(this->x[slot], this->y[slot], this->z[slot]);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), previous + (current - previous) * alpha);
+        this->mesh->addInstance(glm::scale(model, glm::vec3(this->radius[slot])));
+    }
+    this->mesh->submit(queue);
+}
+
+void TargetPool::clear()
+{
+    for(uint32_t slot = 0; slot < this->used; slot++)
+    {
+        this->alive[slot] = 0;
+        this->radius[slot] = DEAD_RADIUS;
+    }
+    this->freeSlots.clear();
+    this->used = 0;
+    this->count = 0;
+
+    if(this->mesh) this->mesh->destroy();
+    this->mesh.reset();
+    this->prototype.reset();
+}
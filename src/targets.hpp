@@ -0,0 +1,101 @@
+#ifndef __TARGETS_HPP__
+#define __TARGETS_HPP__
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "sphere_model.hpp"
+#include "instanced_mesh.hpp"
+#include "render_queue.hpp"
+#include "raycast.hpp"
+#include "frustum.hpp"
+
+// Targets alive at once, every array of the pool is allocated for this many up front
+const uint32_t MAX_TARGETS = 1024;
+// Spawn defaults for the standard drill
+const float TARGET_RADIUS = 0.06f;
+const float TARGET_LIFETIME = 3.0f;  // Seconds before an unhit target counts as a miss
+const float TARGET_SPAWN_RATE = 2.0f; // Targets per second
+
+enum TargetPattern
+{
+    PATTERN_STATIC, // Stays where it spawned
+    PATTERN_STRAFE, // Swings side to side along a horizontal axis
+    PATTERN_CIRCLE, // Orbits its spawn point in the horizontal plane
+    PATTERN_COUNT,
+};
+
+/**
+ * Every target lives in a fixed size structure of arrays pool. Dead slots
+ * go on a free list and are handed out again by the next spawn, so a
+ * drill spawning hundreds of targets a second never touches the heap.
+ * Dead slots keep a negative radius, letting the hit test run over the
+ * whole used range without checking liveness.
+ *
+ * The pool is advanced on simulation ticks and drawn through one
+ * InstancedMesh, interpolated between the last two ticks.
+ */
+class TargetPool
+{
+    private:
+        // Per target state, indexed by slot
+        std::vector<float> x, y, z, radius;
+        std::vector<float> previousX, previousY, previousZ; // Position at the previous tick
+        std::vector<float> originX, originY, originZ;       // Anchor the pattern moves around
+        std::vector<float> axisX, axisZ;                    // Strafe direction
+        std::vector<float> amplitude, speed, phase;
+        std::vector<float> age, lifetime;
+        std::vector<uint8_t> pattern;
+        std::vector<uint8_t> alive;
+
+        std::vector<uint32_t> freeSlots; // Stack of dead slots below used
+        uint32_t used;  // One past the highest slot ever handed out
+        uint32_t count; // Live targets
+
+        AABB arena;
+        float spawnRate, spawnTimer;
+        uint32_t random; // xorshift32 state, seeded so a drill can be replayed
+
+        std::unique_ptr<SphereModel> prototype;
+        std::unique_ptr<InstancedMesh> mesh;
+
+        float nextRandom(); // In [0, 1)
+        void place(uint32_t slot);
+
+    public:
+        unsigned int hits, misses;
+
+        TargetPool();
+
+        // Loads the target mesh, needs a current GL context
+        void init();
+        // Targets spawn inside this box
+        void setArena(const AABB& arena) { this->arena = arena; }
+        // Targets spawned per second by update(), 0 stops spawning
+        void setSpawnRate(float rate) { spawnRate = rate; }
+        void seed(uint32_t seed) { random = seed ? seed : 1; }
+
+        // The position is pulled in so the target and its whole motion stay inside the arena.
+        // Returns the new slot, or MAX_TARGETS if the pool is full
+        uint32_t spawn(const glm::vec3& position, TargetPattern pattern, float radius = TARGET_RADIUS, float lifetime = TARGET_LIFETIME);
+        // Spawns one target at a random spot in the arena with a random pattern
+        uint32_t spawnRandom();
+        void despawn(uint32_t slot);
+        // Marks a target as shot, false if it was already gone (e.g. a second pellet of the same shot)
+        bool hit(uint32_t slot);
+
+        // Advances every target by one simulation tick
+        void update(float dt);
+        // Closest target along each ray, hits[i] is only replaced by something nearer
+        void raycast(const Ray* rays, size_t rayCount, RayHit* hits) const;
+        // Queues every live target, alpha blends between the last two ticks
+        void submit(RenderQueue& queue, float alpha);
+        // Despawns everything and releases the mesh, must be called while the context is alive
+        void clear();
+
+        uint32_t liveCount() const { return count; }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "texture.hpp"
+#include "render_queue.hpp"
 
 
 Texture2D::Texture2D()
@@ -14,7 +15,7 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     this->Width = width;
     this->Height = height;
     // create Texture
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    RenderState::BindTexture(0, this->ID);
     glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
     // set Texture wrap and filter modes
@@ -23,11 +24,36 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::BindTexture(0, 0);
+}
+
+void Texture2D::GenerateLevels(const TextureLevel* levels, unsigned int count, bool compressed)
+{
+    this->Width = levels[0].Width;
+    this->Height = levels[0].Height;
+    RenderState::BindTexture(0, this->ID);
+    for (unsigned int level = 0; level < count; level++)
+    {
+        const TextureLevel &mip = levels[level];
+        if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, mip.Width, mip.Height, 0, mip.Size, mip.Data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, mip.Width, mip.Height, 0, this->Image_Format, GL_UNSIGNED_BYTE, mip.Data);
+    }
+    // the chain is complete, sampling must not look past it
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+    // set Texture wrap and filter modes
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+    // unbind texture
+    RenderState::BindTexture(0, 0);
 }
 
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    RenderState::BindTexture(0, this->ID);
 }
 
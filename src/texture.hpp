@@ -1,8 +1,17 @@
 #ifndef __TEXTURE_HPP__
 #define __TEXTURE_HPP__
 
+#include <cstddef>
 #include <glad/glad.h>
 
+// One level of a pre-built mip chain. With a pixel unpack buffer bound, Data is an offset into it
+struct TextureLevel
+{
+    unsigned int Width, Height;
+    const unsigned char* Data;
+    size_t Size; // bytes, needed for compressed uploads
+};
+
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
 class Texture2D
@@ -24,7 +33,9 @@ public:
     Texture2D();
     // generates texture from image data
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
-    // binds the texture as the current active GL_TEXTURE_2D texture object
+    // generates texture from a complete mip chain, compressed if Internal_Format is a compressed format. No mipmaps are generated at runtime
+    void GenerateLevels(const TextureLevel* levels, unsigned int count, bool compressed);
+    // binds the texture on unit 0 through RenderState
     void Bind() const;
 };
 
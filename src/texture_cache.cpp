@@ -0,0 +1,386 @@
+#include "texture_cache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gl_ext.hpp"
+#include "stb_image.h"
+
+std::string TextureCache::Directory = "cache/textures";
+
+// Bump whenever the file layout or the cooking changes, old files are then rebuilt
+static const uint32_t CACHE_VERSION = 2;
+static const char CACHE_MAGIC[4] = { 'A', 'T', 'E', 'X' };
+
+// On-disk layout: Header, LevelEntry[levelCount], level data
+struct TextureCache::Header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t alpha;
+    uint32_t levelCount;
+    uint32_t reserved;
+    uint64_t sourceSize;  // the source file this was cooked from, checked on load
+    int64_t  sourceMTime;
+};
+
+struct TextureCache::LevelEntry
+{
+    uint32_t width, height;
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+};
+
+size_t CookedTexture::dataSize() const
+{
+    size_t size = 0;
+    for (const TextureLevel &level : levels)
+        size += level.Size;
+    return size;
+}
+
+/**
+ * CPU side image processing
+ */
+
+// Halves an image with a box filter, odd edges reuse the last row/column
+static std::vector<unsigned char> downsample(const std::vector<unsigned char> &src, unsigned int width, unsigned int height, unsigned int channels)
+{
+    unsigned int dstWidth = std::max(1u, width / 2), dstHeight = std::max(1u, height / 2);
+    std::vector<unsigned char> dst((size_t)dstWidth * dstHeight * channels);
+    for (unsigned int y = 0; y < dstHeight; y++)
+    {
+        unsigned int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (unsigned int x = 0; x < dstWidth; x++)
+        {
+            unsigned int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            for (unsigned int c = 0; c < channels; c++)
+            {
+                unsigned int sum = src[((size_t)y0 * width + x0) * channels + c] + src[((size_t)y0 * width + x1) * channels + c]
+                                 + src[((size_t)y1 * width + x0) * channels + c] + src[((size_t)y1 * width + x1) * channels + c];
+                dst[((size_t)y * dstWidth + x) * channels + c] = (sum + 2) / 4;
+            }
+        }
+    }
+    return dst;
+}
+
+static uint16_t packRGB565(const int *rgb)
+{
+    return (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+static void unpackRGB565(uint16_t color, int *rgb)
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Encodes one 4x4 RGB block: bounding box endpoints, inset slightly, nearest of the 4 palette colors per pixel
+static void encodeBC1Block(const unsigned char block[16][3], unsigned char *out)
+{
+    int minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+        {
+            minColor[c] = std::min(minColor[c], (int)block[i][c]);
+            maxColor[c] = std::max(maxColor[c], (int)block[i][c]);
+        }
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (maxColor[c] - minColor[c]) / 16;
+        minColor[c] = std::min(255, minColor[c] + inset);
+        maxColor[c] = std::max(0, maxColor[c] - inset);
+    }
+
+    uint16_t color0 = packRGB565(maxColor), color1 = packRGB565(minColor);
+    uint32_t indices = 0;
+    if (color0 < color1)
+        std::swap(color0, color1);
+    if (color0 != color1)
+    {
+        // color0 > color1 selects the opaque 4 color mode
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++)
+            {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    // little endian: color0, color1, 2 bit indices row by row
+    out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+static std::vector<unsigned char> encodeBC1(const std::vector<unsigned char> &rgb, unsigned int width, unsigned int height)
+{
+    unsigned int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<unsigned char> out((size_t)blocksX * blocksY * 8);
+    unsigned char block[16][3];
+    for (unsigned int by = 0; by < blocksY; by++)
+        for (unsigned int bx = 0; bx < blocksX; bx++)
+        {
+            // blocks hanging over the edge repeat the last pixel
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                unsigned int x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                memcpy(block[i], &rgb[((size_t)y * width + x) * 3], 3);
+            }
+            encodeBC1Block(block, &out[((size_t)by * blocksX + bx) * 8]);
+        }
+    return out;
+}
+
+/**
+ * Cache files
+ */
+
+static bool statSource(const std::string &source, uint64_t &size, int64_t &mtime)
+{
+    struct stat info;
+    if (stat(source.c_str(), &info) != 0)
+        return false;
+    size = info.st_size;
+    // nanoseconds, an edit saved within the same second as the last cook must still count
+    mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+std::string TextureCache::CachePath(const std::string &source)
+{
+    std::string name = source;
+    for (char &c : name)
+        if (c == '/' || c == '\\' || c == ':')
+            c = '_';
+    return Directory + "/" + name + ".atex";
+}
+
+unsigned int TextureCache::InternalFormat(CookedFormat format)
+{
+    switch (format)
+    {
+        case COOKED_BC1:   return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case COOKED_RGBA8: return GL_RGBA8;
+        default:           return GL_RGB8;
+    }
+}
+
+bool TextureCache::cook(const std::string &source, bool alpha, bool compress, std::vector<unsigned char> &file)
+{
+    Header header;
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    header.alpha = alpha;
+    header.reserved = 0;
+    if (!statSource(source, header.sourceSize, header.sourceMTime))
+    {
+        std::cout << "ERROR::TEXTURE: Missing source image " << source << std::endl;
+        return false;
+    }
+
+    unsigned int channels = alpha ? 4 : 3;
+    int width, height, fileChannels;
+    unsigned char *pixels = stbi_load(source.c_str(), &width, &height, &fileChannels, channels);
+    if (pixels == nullptr)
+    {
+        std::cout << "ERROR::TEXTURE: Failed to decode " << source << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    // BC1 has no alpha channel, alpha textures stay uncompressed
+    CookedFormat format = compress && !alpha ? COOKED_BC1 : (alpha ? COOKED_RGBA8 : COOKED_RGB8);
+    header.format = format;
+
+    // Build the whole chain down to 1x1
+    std::vector<std::vector<unsigned char>> levels;
+    std::vector<LevelEntry> entries;
+    std::vector<unsigned char> image(pixels, pixels + (size_t)width * height * channels);
+    stbi_image_free(pixels);
+    unsigned int levelWidth = width, levelHeight = height;
+    while (true)
+    {
+        levels.push_back(format == COOKED_BC1 ? encodeBC1(image, levelWidth, levelHeight) : image);
+        entries.push_back({ levelWidth, levelHeight, 0, levels.back().size() });
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        image = downsample(image, levelWidth, levelHeight, channels);
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+    header.levelCount = levels.size();
+
+    // Lay the file out
+    size_t offset = sizeof(Header) + entries.size() * sizeof(LevelEntry);
+    for (LevelEntry &entry : entries)
+    {
+        entry.offset = offset;
+        offset += entry.size;
+    }
+    file.resize(offset);
+    memcpy(file.data(), &header, sizeof(Header));
+    memcpy(file.data() + sizeof(Header), entries.data(), entries.size() * sizeof(LevelEntry));
+    for (size_t i = 0; i < levels.size(); i++)
+        memcpy(file.data() + entries[i].offset, levels[i].data(), levels[i].size());
+
+    std::cout << "[DEBUG] Cooked " << source << " (" << width << "x" << height << ", " << levels.size() << " levels, "
+              << (format == COOKED_BC1 ? "BC1" : "raw") << ")" << std::endl;
+    return true;
+}
+
+bool TextureCache::parse(const unsigned char *bytes, size_t size, CookedTexture &out)
+{
+    if (size < sizeof(Header))
+        return false;
+    const Header *header = (const Header *)bytes;
+    if (size < sizeof(Header) + header->levelCount * sizeof(LevelEntry) || header->levelCount == 0)
+        return false;
+
+    const LevelEntry *entries = (const LevelEntry *)(bytes + sizeof(Header));
+    out.format = (CookedFormat)header->format;
+    out.levels.clear();
+    for (uint32_t i = 0; i < header->levelCount; i++)
+    {
+        if (entries[i].offset + entries[i].size > size)
+            return false;
+        out.levels.push_back({ entries[i].width, entries[i].height, bytes + entries[i].offset, (size_t)entries[i].size });
+    }
+    return true;
+}
+
+bool TextureCache::open(const std::string &path, const Header &expected, CookedTexture &out)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header))
+    {
+        close(fd);
+        return false;
+    }
+
+    // Populate up front, the pages are read on this (worker) thread rather than the GL thread
+    size_t size = info.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const Header *header = (const Header *)mapping;
+    bool valid = memcmp(header->magic, CACHE_MAGIC, 4) == 0
+              && header->version == expected.version
+              && header->format == expected.format
+              && header->alpha == expected.alpha
+              && header->sourceSize == expected.sourceSize
+              && header->sourceMTime == expected.sourceMTime
+              && parse((const unsigned char *)mapping, size, out);
+    if (!valid)
+    {
+        munmap(mapping, size);
+        out.levels.clear();
+        return false;
+    }
+
+    out.mapping = mapping;
+    out.mappingSize = size;
+    return true;
+}
+
+bool TextureCache::write(const std::string &path, const std::vector<unsigned char> &file)
+{
+    // mkdir -p
+    for (size_t slash = Directory.find('/'); ; slash = Directory.find('/', slash + 1))
+    {
+        mkdir(Directory.substr(0, slash).c_str(), 0755);
+        if (slash == std::string::npos)
+            break;
+    }
+
+    // Written aside and renamed so concurrent loaders never see a partial file
+    std::stringstream tmp;
+    tmp << path << ".tmp." << std::this_thread::get_id();
+    {
+        std::ofstream out(tmp.str(), std::ios::binary);
+        if (!out.write((const char *)file.data(), file.size()))
+            return false;
+    }
+    return std::rename(tmp.str().c_str(), path.c_str()) == 0;
+}
+
+bool TextureCache::Load(const std::string &source, bool alpha, bool compress, CookedTexture &out)
+{
+    Header expected;
+    expected.version = CACHE_VERSION;
+    expected.alpha = alpha;
+    expected.format = compress && !alpha ? COOKED_BC1 : (alpha ? COOKED_RGBA8 : COOKED_RGB8);
+    if (!statSource(source, expected.sourceSize, expected.sourceMTime))
+    {
+        std::cout << "ERROR::TEXTURE: Missing source image " << source << std::endl;
+        return false;
+    }
+
+    std::string path = CachePath(source);
+    if (open(path, expected, out))
+        return true;
+
+    std::vector<unsigned char> file;
+    if (!cook(source, alpha, compress, file))
+        return false;
+    if (write(path, file) && open(path, expected, out))
+        return true;
+
+    // Read-only install, keep the cooked texture in memory for this run
+    std::cout << "[DEBUG] Could not write texture cache " << path << ", using it from memory" << std::endl;
+    out.memory.swap(file);
+    return parse(out.memory.data(), out.memory.size(), out);
+}
+
+bool TextureCache::Cook(const std::string &source, bool alpha, bool compress)
+{
+    std::vector<unsigned char> file;
+    return cook(source, alpha, compress, file) && write(CachePath(source), file);
+}
+
+void TextureCache::Release(CookedTexture &texture)
+{
+    if (texture.mapping != nullptr)
+        munmap(texture.mapping, texture.mappingSize);
+    texture.mapping = nullptr;
+    texture.mappingSize = 0;
+    std::vector<unsigned char>().swap(texture.memory);
+    texture.levels.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef __TEXTURE_CACHE_HPP__
+#define __TEXTURE_CACHE_HPP__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "texture.hpp"
+
+// Pixel formats a cooked texture can be stored in
+enum CookedFormat
+{
+    COOKED_RGB8  = 0,
+    COOKED_RGBA8 = 1,
+    COOKED_BC1   = 2, // S3TC DXT1, 4 bits per pixel, opaque RGB only. An eighth of RGB8, which drivers store at 4 bytes per texel
+};
+
+// A texture with its full mip chain ready for upload. Level data points
+// either into a memory-mapped cache file or into the owned buffer.
+struct CookedTexture
+{
+    CookedFormat format;
+    std::vector<TextureLevel> levels;
+
+    void *mapping = nullptr; // mmap of the cache file
+    size_t mappingSize = 0;
+    std::vector<unsigned char> memory; // used when the cache file could not be written
+
+    CookedTexture() { }
+    // level pointers may point into memory, so the texture can be moved but never copied
+    CookedTexture(const CookedTexture &) = delete;
+    CookedTexture &operator=(const CookedTexture &) = delete;
+    CookedTexture(CookedTexture &&) = default;
+    CookedTexture &operator=(CookedTexture &&) = default;
+
+    // bytes of all levels, stored back to back
+    const unsigned char *data() const { return levels.empty() ? nullptr : levels[0].Data; }
+    size_t dataSize() const;
+};
+
+// A static on-disk cache of cooked textures. The first load of an image
+// decodes it, builds the mip chain on the CPU, optionally encodes it to
+// BC1 and writes it under Directory. Later loads memory-map that file
+// and upload straight from it, skipping decode and mipmap generation.
+// Entries are rebuilt when the source file's size or mtime changes.
+class TextureCache
+{
+public:
+    // where cooked files are stored, relative to the working directory
+    static std::string Directory;
+
+    // fills out from the cache, cooking the source first if needed. Thread safe, does not touch GL
+    static bool Load(const std::string &source, bool alpha, bool compress, CookedTexture &out);
+    // cooks the source and writes its cache file unconditionally, used by the offline cooker
+    static bool Cook(const std::string &source, bool alpha, bool compress);
+    // unmaps or frees the texture data
+    static void Release(CookedTexture &texture);
+    // path of the cache file for a source image
+    static std::string CachePath(const std::string &source);
+    // the GL internal format to upload a cooked format with
+    static unsigned int InternalFormat(CookedFormat format);
+private:
+    TextureCache() { }
+
+    struct Header;
+    struct LevelEntry;
+
+    static bool cook(const std::string &source, bool alpha, bool compress, std::vector<unsigned char> &file);
+    static bool open(const std::string &path, const Header &expected, CookedTexture &out);
+    static bool parse(const unsigned char *bytes, size_t size, CookedTexture &out);
+    static bool write(const std::string &path, const std::vector<unsigned char> &file);
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "texture_loader.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include "resource_mgr.hpp"
+#include "gl_ext.hpp"
+
+std::vector<std::thread>              TextureLoader::workers;
+std::deque<TextureLoader::Job>        TextureLoader::jobs;
+std::vector<TextureLoader::DecodedImage> TextureLoader::finished;
+std::mutex                            TextureLoader::jobMutex;
+std::mutex                            TextureLoader::finishedMutex;
+std::condition_variable               TextureLoader::jobReady;
+std::condition_variable               TextureLoader::imageReady;
+bool                                  TextureLoader::stopping = false;
+unsigned int                          TextureLoader::pending = 0;
+unsigned int                          TextureLoader::PBO = 0;
+
+void TextureLoader::Init(unsigned int workerCount)
+{
+    if(!workers.empty()) return;
+
+    if(workerCount == 0)
+    {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    stopping = false;
+    for(unsigned int i = 0; i < workerCount; i++) workers.emplace_back(workerLoop);
+    std::cout << "[DEBUG] Texture loader started with " << workerCount << " workers" << std::endl;
+}
+
+void TextureLoader::Request(unsigned int handle, const std::string &file, bool alpha)
+{
+    if(workers.empty()) Init();
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back({ handle, file, alpha, GLExt::TextureCompressionS3TC });
+    }
+    pending++;
+    jobReady.notify_one();
+}
+
+void TextureLoader::workerLoop()
+{
+    while(true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [] { return stopping || !jobs.empty(); });
+            if(stopping) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        // Maps the cooked file, decoding and cooking the source first if there is none
+        DecodedImage image;
+        image.handle = job.handle;
+        image.file = job.file;
+        image.loaded = TextureCache::Load(job.file, job.alpha, job.compress, image.texture);
+
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            finished.push_back(std::move(image));
+        }
+        imageReady.notify_one();
+    }
+}
+
+void TextureLoader::Update(unsigned int maxUploads)
+{
+    std::vector<DecodedImage> ready;
+    {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        if(finished.empty()) return;
+
+        size_t count = std::min<size_t>(maxUploads, finished.size());
+        ready.assign(std::make_move_iterator(finished.begin()), std::make_move_iterator(finished.begin() + count));
+        finished.erase(finished.begin(), finished.begin() + count);
+    }
+
+    for(DecodedImage &image: ready)
+    {
+        upload(image);
+        TextureCache::Release(image.texture);
+        pending--;
+    }
+}
+
+void TextureLoader::upload(const DecodedImage &image)
+{
+    if(!image.loaded)
+    {
+        // Keep the placeholder so the missing texture is obvious on screen
+        std::cout << "ERROR::TEXTURE: Failed to load " << image.file << std::endl;
+        return;
+    }
+
+    // Levels are stored back to back, the whole chain goes through one buffer
+    const CookedTexture &cooked = image.texture;
+    size_t size = cooked.dataSize();
+    if(PBO == 0) glGenBuffers(1, &PBO);
+
+    // Orphan the previous storage so the driver never waits on an upload still in flight
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(mapped == nullptr)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        std::cout << "ERROR::TEXTURE: Failed to map upload buffer for " << image.file << std::endl;
+        return;
+    }
+    memcpy(mapped, cooked.data(), size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With the PBO bound the level pointers become offsets into it
+    std::vector<TextureLevel> levels = cooked.levels;
+    for(TextureLevel &level: levels) level.Data = (const unsigned char *)(level.Data - cooked.data());
+
+    // RGB rows are not always 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    Texture2D &texture = ResourceManager::Textures[image.handle];
+    texture.Internal_Format = TextureCache::InternalFormat(cooked.format);
+    texture.GenerateLevels(levels.data(), levels.size(), cooked.format == COOKED_BC1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    std::cout << "[DEBUG] Loaded " << image.file << " with dimensions: (" << texture.Width << ", " << texture.Height << ")" << std::endl;
+}
+
+void TextureLoader::Finish()
+{
+    while(pending > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            imageReady.wait(lock, [] { return !finished.empty(); });
+        }
+        Update(~0u);
+    }
+}
+
+unsigned int TextureLoader::Pending()
+{
+    return pending;
+}
+
+void TextureLoader::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+        jobs.clear();
+    }
+    jobReady.notify_all();
+    for(auto &worker: workers) worker.join();
+    workers.clear();
+
+    for(auto &image: finished) TextureCache::Release(image.texture);
+    finished.clear();
+    pending = 0;
+
+    if(PBO != 0) glDeleteBuffers(1, &PBO);
+    PBO = 0;
+}
+
+void TextureLoader::GeneratePlaceholder(Texture2D &texture)
+{
+    // 2x2 grey checkerboard
+    const unsigned char grey[] = { 96, 96, 96, 255 }, light[] = { 160, 160, 160, 255 };
+    unsigned int channels = texture.Image_Format == GL_RGBA ? 4 : 3;
+    unsigned char pixels[4 * 4];
+    const unsigned char *order[] = { grey, light, light, grey };
+    for(unsigned int i = 0; i < 4; i++) memcpy(pixels + i * channels, order[i], channels);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    texture.Generate(2, 2, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,76 @@
+#ifndef __TEXTURE_LOADER_HPP__
+#define __TEXTURE_LOADER_HPP__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "texture.hpp"
+#include "texture_cache.hpp"
+
+// Uploads done per Update() call, bounds the time the render thread spends on them
+const unsigned int MAX_UPLOADS_PER_UPDATE = 4;
+
+// A static pool of worker threads loading texture files in parallel
+// through the TextureCache (mapping a cooked file, or decoding and cooking
+// it on first use).
+// The render thread owns every GL call: it hands out a placeholder
+// texture straight away and, from Update(), streams finished images into
+// that same texture object through a pixel buffer object, so handles
+// and texture IDs never change.
+class TextureLoader
+{
+public:
+    // starts the workers, 0 picks one per spare hardware thread
+    static void Init(unsigned int workers = 0);
+    // queues a file to be decoded into the given texture, which should already hold a placeholder. GL thread only
+    static void Request(unsigned int handle, const std::string &file, bool alpha);
+    // uploads finished images, call once per frame from the GL thread
+    static void Update(unsigned int maxUploads = MAX_UPLOADS_PER_UPDATE);
+    // blocks until every requested texture is decoded and uploaded
+    static void Finish();
+    // textures requested but not uploaded yet
+    static unsigned int Pending();
+    // stops the workers and frees the pixel buffer, must be called while the context is alive
+    static void Shutdown();
+    // fills a texture with a small checkerboard shown until its image arrives
+    static void GeneratePlaceholder(Texture2D &texture);
+private:
+    TextureLoader() { }
+
+    struct Job
+    {
+        unsigned int handle;
+        std::string file;
+        bool alpha;
+        bool compress; // decided on the GL thread from the context's capabilities
+    };
+
+    struct DecodedImage
+    {
+        unsigned int handle;
+        std::string file;
+        bool loaded; // false if the file could not be read
+        CookedTexture texture;
+    };
+
+    static std::vector<std::thread> workers;
+    static std::deque<Job> jobs;
+    static std::vector<DecodedImage> finished;
+    static std::mutex jobMutex, finishedMutex;
+    static std::condition_variable jobReady, imageReady;
+    static bool stopping;
+    static unsigned int pending;
+
+    static unsigned int PBO;
+
+    static void workerLoop();
+    static void upload(const DecodedImage &image);
+};
+
+#endif
@@ -1,7 +1,9 @@
 #include "wall_model.hpp"
 
-WallModel::WallModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float width, float height, glm::vec3 center_pos, glm::vec3 normal)
-: ObjectModel(shaderName, textureName, useEBO, useTexture)
+#include <algorithm>
+
+WallModel::WallModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float width, float height, glm::vec3 center_pos, glm::vec3 normal, bool batched)
+: ObjectModel(shaderName, textureName, useEBO, useTexture, batched)
 {
     // Our walls should always use EBOs
     if ( !useEBO ) throw std::runtime_error("Walls should use element buffers");
@@ -23,62 +25,66 @@ WallModel::WallModel(std::string shaderName, std::string textureName, bool useEB
 
 }
 
-void WallModel::generateGeometry()
+void WallModel::GenerateQuad(float width, float height, float *vertices)
 {
-    this->vertices = {
-        // X                 Y               Z     Texture Coords
-        -this->width / 2, -this->height / 2, 0.0f, 0.0f, 0.0f, // Bottom Left
-        -this->width / 2,  this->height / 2, 0.0f, 0.0f, 1.0f, // Top Left
-         this->width / 2, -this->height / 2, 0.0f, 1.0f, 0.0f, // Bottom Right
-         this->width / 2,  this->height / 2, 0.0f, 1.0f, 1.0f,  // Top Right        
+    const float quad[WALL_VERTEX_COUNT * FLOATS_PER_VERTEX] = {
+        // X           Y            Z     Texture Coords
+        -width / 2, -height / 2, 0.0f, 0.0f, 0.0f, // Bottom Left
+        -width / 2,  height / 2, 0.0f, 0.0f, 1.0f, // Top Left
+         width / 2, -height / 2, 0.0f, 1.0f, 0.0f, // Bottom Right
+         width / 2,  height / 2, 0.0f, 1.0f, 1.0f, // Top Right
     };
+    std::copy(quad, quad + WALL_VERTEX_COUNT * FLOATS_PER_VERTEX, vertices);
+}
+
+void WallModel::generateGeometry()
+{
+    this->vertices.resize(WALL_VERTEX_COUNT * FLOATS_PER_VERTEX);
+    GenerateQuad(this->width, this->height, this->vertices.data());
 
-    this->indices = {
-        0, 1, 2, 
-        1, 2, 3,
-    }; // Order in which vertices should be drawn
+    // Order in which vertices should be drawn
+    this->indices.assign(WALL_INDICES, WALL_INDICES + WALL_INDEX_COUNT);
 }
 
 void WallModel::init()
 {
-    // Generate the Vertex Array Buffer and the Vertex Buffer Objects
-    glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &this->VBO);
-
-    if(useEBO) glGenBuffers(1, &this->EBO);
-    
-    glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(float), this->vertices.data(), GL_STATIC_DRAW);
-    
-    if(useEBO)
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(unsigned int), this->indices.data(), GL_STATIC_DRAW);
-    }
-    
-    // This is based on our current implementation of a textured wall
-    const size_t stride = 5 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) 0);
-    glEnableVertexAttribArray(0);
-    
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void *) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
     // Load the shaders and textures
-    ResourceManager::LoadShader((this->shaderName + ".vs").c_str(), (this->shaderName + ".fs").c_str(), nullptr, this->shaderName);
-    if(useTexture) ResourceManager::LoadTexture(this->textureName.c_str(), false, this->textureName);
-    
+    this->shader = ResourceManager::LoadShader((this->shaderName + ".vs").c_str(), (this->shaderName + ".fs").c_str(), nullptr, this->shaderName);
+    if(useTexture) this->texture = ResourceManager::LoadTextureAsync(this->textureName.c_str(), false, this->textureName);
+
+    // The sampler always reads unit 0, set it once instead of every draw
+    const Shader &shader = ResourceManager::GetShader(this->shader);
+    this->modelUniform = shader.GetUniform<glm::mat4>("model");
+    if(useTexture) shader.SetInteger("tex", 0, true);
+
+    // Batched walls are uploaded as part of their StaticBatch
+    if(batched) return;
+
+    this->uploadGeometry();
+}
+
+void WallModel::setCenter(glm::vec3 center_pos)
+{
+    this->center_pos = center_pos;
+    this->markTransformDirty();
 }
 
-void WallModel::draw(glm::mat4 projection, glm::mat4 view)
+void WallModel::setNormal(glm::vec3 normal)
 {
-    // Use our shader
-    ResourceManager::GetShader(this->shaderName).Use();
+    this->normal = normal;
+    this->markTransformDirty();
+}
 
-    // Update the model matrix by translating and rotating to our position
+glm::mat4 WallModel::computeModelMatrix() const
+{
+    return Placement(this->center_pos, this->normal);
+}
+
+glm::mat4 WallModel::Placement(const glm::vec3& center, const glm::vec3& normal)
+{
+    // Translate and rotate the wall to our position
     glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, this->center_pos); // translated
+    model = glm::translate(model, center); // translated
 
     /**
      * For rotation to match the normal, angle is calculated by using the dot product
@@ -86,29 +92,51 @@ void WallModel::draw(glm::mat4 projection, glm::mat4 view)
      */
 
     auto face = glm::vec3(0.0f, 0.0f, 1.0f);
-    auto axis = glm::cross(face, this->normal);
-    auto angle = glm::acos( glm::dot(face, this->normal) ); // Here it is sure that the vectors are unit vectors.
+    auto axis = glm::cross(face, normal);
+    auto angle = glm::acos( glm::dot(face, normal) ); // Here it is sure that the vectors are unit vectors.
 
     // If we are already along the normal we don't need to rotate
     if( angle != 0.0f ) model = glm::rotate(model, angle, axis);
 
-    // Write the Model, View, projection matrices to the shader
-    ResourceManager::GetShader(this->shaderName).SetMatrix4("model", model);
-    ResourceManager::GetShader(this->shaderName).SetMatrix4("view", view);
-    ResourceManager::GetShader(this->shaderName).SetMatrix4("projection", projection);
+    return model;
+}
+
+CollisionQuad WallModel::getCollisionQuad() const
+{
+    return PlacedQuad(this->getModelMatrix(), this->width, this->height);
+}
+
+CollisionQuad WallModel::PlacedQuad(const glm::mat4& model, float width, float height)
+{
+    // The model matrix maps the local X/Y/Z axes onto the panel's width, height and normal
+    CollisionQuad quad;
+    quad.center = glm::vec3(model[3]);
+    quad.axisU = glm::normalize(glm::vec3(model[0]));
+    quad.axisV = glm::normalize(glm::vec3(model[1]));
+    quad.normal = glm::normalize(glm::vec3(model[2]));
+    quad.halfU = std::fabs(width) / 2;
+    quad.halfV = std::fabs(height) / 2;
+    return quad;
+}
+
+void WallModel::draw()
+{
+    if(batched) throw std::runtime_error("Batched walls are drawn by their StaticBatch");
+
+    // Use our shader, skipped if it is already bound
+    const Shader &shader = ResourceManager::GetShader(this->shader);
+    RenderState::UseProgram(shader.ID);
+
+    // Cached, only recomputed if the wall moved since the last frame
+    // View and projection come from the shared camera uniform buffer
+    shader.Set(this->modelUniform, this->getModelMatrix());
 
     // Use the Textures
-    if(useTexture)
-    {
-        // Apply the texture
-        ResourceManager::GetShader(this->shaderName).SetInteger("tex", 0);
-        glActiveTexture(GL_TEXTURE0);
-        ResourceManager::GetTexture(this->textureName).Bind();
-    }
+    if(useTexture) RenderState::BindTexture(0, ResourceManager::GetTexture(this->texture).ID);
 
-    glBindVertexArray(this->VAO);
+    RenderState::BindVertexArray(this->VAO);
 
-    if(useEBO) glDrawElements( GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    if(useEBO) glDrawElements( GL_TRIANGLES, indices.size(), this->indexType, 0);
     else{
         throw std::runtime_error("Current Walls should use the EBOs always!");
     } 
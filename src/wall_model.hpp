@@ -1,4 +1,12 @@
+#ifndef __WALL_MODEL_HPP__
+#define __WALL_MODEL_HPP__
+
 #include "object_model.hpp"
+#include "collision.hpp"
+
+const unsigned int WALL_VERTEX_COUNT = 4;
+const unsigned int WALL_INDEX_COUNT = 6;
+const unsigned int WALL_INDICES[WALL_INDEX_COUNT] = { 0, 1, 2, 1, 2, 3 };
 
 class WallModel : public ObjectModel
 {   
@@ -10,9 +18,27 @@ class WallModel : public ObjectModel
     protected:
         void generateGeometry();
         void init();
+        glm::mat4 computeModelMatrix() const override;
 
     public:
-        WallModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float width, float height, glm::vec3 center_pos, glm::vec3 normal);
-        void draw(glm::mat4 projection, glm::mat4 view);
+        WallModel(std::string shaderName, std::string textureName, bool useEBO, bool useTexture, float width, float height, glm::vec3 center_pos, glm::vec3 normal, bool batched = false);
+        void draw();
+
+        // Moving the wall invalidates the cached model matrix
+        void setCenter(glm::vec3 center_pos);
+        void setNormal(glm::vec3 normal);
+        glm::vec3 getCenter() const { return center_pos; }
+        glm::vec3 getNormal() const { return normal; }
+        // The placed panel as seen by the collision system
+        CollisionQuad getCollisionQuad() const;
+
+        // Panel geometry without a WallModel, for building walls straight from level records.
+        // Fills WALL_VERTEX_COUNT vertices of FLOATS_PER_VERTEX floats, drawn with WALL_INDICES
+        static void GenerateQuad(float width, float height, float *vertices);
+        // Places the local quad at center, facing along the unit normal
+        static glm::mat4 Placement(const glm::vec3& center, const glm::vec3& normal);
+        static CollisionQuad PlacedQuad(const glm::mat4& model, float width, float height);
+
+};
 
-};
\ No newline at end of file
+#endif
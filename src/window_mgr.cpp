@@ -1,12 +1,13 @@
 #include "window_mgr.hpp"
 
-GLFWwindow* initWindow(int width, int height, const char* windowTitle)
+GLFWwindow* initWindow(int width, int height, const char* windowTitle, bool visible)
 {
     // 1. Initialize window and provide hints
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // Select core profile
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
     
     // 2. Create a window
     GLFWwindow* window = glfwCreateWindow(width, height, windowTitle, NULL, NULL);
@@ -23,6 +24,7 @@ GLFWwindow* initWindow(int width, int height, const char* windowTitle)
         std::string err = "FAILED TO INITIALIZE GLAD FOR " + std::string(windowTitle);
         throw std::runtime_error(err);
     }
+    GLExt::Init((GLADloadproc)glfwGetProcAddress);
     
     // 4. Viewport settings
     glViewport(0, 0, width, height);
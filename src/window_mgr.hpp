@@ -6,6 +6,9 @@
 #include <string>
 #include <stdexcept>
 
-GLFWwindow* initWindow( int width, int height, const char* windowTitle );
+#include "gl_ext.hpp"
+
+// A hidden window still owns a full GL context, used for headless runs
+GLFWwindow* initWindow( int width, int height, const char* windowTitle, bool visible = true );
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <iostream>
+#include <string>
+
+#include "level.hpp"
+
+/**
+ * Level converter: compiles the text authoring form of a level into the
+ * binary form the game memory-maps.
+ *
+ * Usage: levelc input.txt [output.lvl]
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2 || argc > 3)
+    {
+        std::cout << "Usage: " << argv[0] << " input.txt [output.lvl]" << std::endl;
+        return 1;
+    }
+
+    std::string input = argv[1], output;
+    if(argc == 3) output = argv[2];
+    else
+    {
+        output = input;
+        size_t dot = output.rfind('.');
+        if(dot != std::string::npos) output.erase(dot);
+        output += ".lvl";
+    }
+
+    if(!Level::Compile(input, output)) return 1;
+
+    // Map it back once so a broken file is caught here and not in the game
+    Level level;
+    return level.open(output) ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <cstring>
+
+// The cooker links only the texture cache, so it carries its own stb_image
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "texture_cache.hpp"
+
+/**
+ * Offline texture cooker: writes the cache files the game would otherwise
+ * build on first run, so shipped builds start without decoding anything.
+ *
+ * Usage: texcook [--raw] [--alpha] [--out dir] image...
+ *   --raw    keep RGB textures uncompressed (for drivers without S3TC)
+ *   --alpha  cook the following images with an alpha channel
+ */
+int main(int argc, char** argv)
+{
+    bool compress = true, alpha = false;
+    int cooked = 0, failed = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--raw")) compress = false;
+        else if(!strcmp(argv[i], "--alpha")) alpha = true;
+        else if(!strcmp(argv[i], "--out") && i + 1 < argc) TextureCache::Directory = argv[++i];
+        else if(TextureCache::Cook(argv[i], alpha, compress)) cooked++;
+        else failed++;
+    }
+
+    if(cooked + failed == 0)
+    {
+        std::cout << "Usage: " << argv[0] << " [--raw] [--alpha] [--out dir] image..." << std::endl;
+        return 1;
+    }
+    std::cout << "Cooked " << cooked << " textures into " << TextureCache::Directory << ", " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}